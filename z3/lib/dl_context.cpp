@@ -966,6 +966,7 @@ namespace datalog {
         p.insert(":default-table-checker", CPK_SYMBOL, "see :default-table-checked");
         PRIVATE_PARAMS(p.insert(":inline-linear", CPK_BOOL, "try linear inlining method"););
         PRIVATE_PARAMS(p.insert(":inline-linear-branch", CPK_BOOL, "try linear inlining method with potential expansion"););
+        PRIVATE_PARAMS(p.insert(":inline-max-rules", CPK_UINT, "maximum number of rules the eager inliner may create before it stops expanding"););
 
         pdr::dl_interface::collect_params(p);
         insert_timeout(p);
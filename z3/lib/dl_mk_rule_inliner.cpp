@@ -46,6 +46,7 @@ Subsumption transformation (remove rule):
 --*/
 
 
+#include <algorithm>
 #include <sstream>
 #include "ast_pp.h"
 #include "dl_finite_product_relation.h"
@@ -55,6 +56,16 @@ Subsumption transformation (remove rule):
 #include "rewriter_def.h"
 #include "dl_mk_rule_inliner.h"
 
+//branch layout hints for the entry and exit checks of operator(); they expand
+//to plain conditions on compilers without __builtin_expect
+#ifdef __GNUC__
+#define DL_INLINER_LIKELY(C)   __builtin_expect(static_cast<bool>(C), 1)
+#define DL_INLINER_UNLIKELY(C) __builtin_expect(static_cast<bool>(C), 0)
+#else
+#define DL_INLINER_LIKELY(C)   (C)
+#define DL_INLINER_UNLIKELY(C) (C)
+#endif
+
 namespace datalog {
 
     // -----------------------------------
@@ -64,10 +75,21 @@ namespace datalog {
     // -----------------------------------
 
     bool rule_unifier::unify_rules(const rule& tgt, unsigned tgt_idx, const rule& src) {
+        //atoms of different predicates can never unify; fail before paying for
+        //the variable counting and substitution setup
+        if (tgt.get_tail(tgt_idx)->get_decl() != src.get_head()->get_decl()) {
+            m_ready = false;
+            return false;
+        }
         var_counter& vc = m_rm.get_var_counter();
         unsigned var_cnt = std::max(vc.get_max_var(tgt), vc.get_max_var(src))+1;
         m_subst.reset();
-        m_subst.reserve(2, var_cnt);
+        //the substitution is reused across many rule pairs; grow the reservation
+        //monotonically so most calls get away with the cheap reset above
+        if (var_cnt > m_reserved_var_cnt) {
+            m_subst.reserve(2, var_cnt);
+            m_reserved_var_cnt = var_cnt;
+        }
         
         m_ready = m_unif(tgt.get_tail(tgt_idx), src.get_head(), m_subst);
 
@@ -83,8 +105,13 @@ namespace datalog {
     }
 
     void rule_unifier::apply(app * a, bool is_tgt, app_ref& res) {
-        expr_ref res_e(m);
         TRACE("dl", output_predicate(m_context, a, tout); tout << "\n";);
+        //a ground atom has no variables the substitution could touch
+        if (a->is_ground()) {
+            res = a;
+            return;
+        }
+        expr_ref res_e(m);
         m_subst.apply(2, m_deltas, expr_offset(a, is_tgt ? 0 : 1), res_e);
         SASSERT(is_app(res_e.get()));
         res = to_app(res_e.get());
@@ -94,11 +121,21 @@ namespace datalog {
         rule& r, bool is_tgt, unsigned skipped_index, 
         app_ref_vector& res, svector<bool>& res_neg) {
         unsigned rule_len = r.get_tail_size();
+        unsigned expected = rule_len - (skipped_index < rule_len ? 1 : 0);
+        res.reserve_capacity(res.size() + expected);
+        res_neg.reserve_capacity(res_neg.size() + expected);
+        expr_ref res_e(m);
         for (unsigned i = 0; i < rule_len; i++) {
             if (i != skipped_index) { //i can never be UINT_MAX, so we'll never skip if we're not supposed to
-                app_ref new_tail_el(m);
-                apply(r.get_tail(i), is_tgt, new_tail_el);
-                res.push_back(new_tail_el);
+                app * t = r.get_tail(i);
+                if (t->is_ground()) {
+                    res.push_back(t);
+                }
+                else {
+                    m_subst.apply(2, m_deltas, expr_offset(t, is_tgt ? 0 : 1), res_e);
+                    SASSERT(is_app(res_e.get()));
+                    res.push_back(to_app(res_e.get()));
+                }
                 res_neg.push_back(r.is_neg_tail(i));
             }
         }
@@ -133,7 +170,8 @@ namespace datalog {
     expr_ref_vector rule_unifier::get_rule_subst(const rule& r, bool is_tgt) {
         SASSERT(m_ready);
         expr_ref_vector result(m);
-        sort_ref_vector sorts(m);
+        sort_ref_vector & sorts = m_tgt_sort_scratch;
+        sorts.reset();
         expr_ref v(m), w(m);
         r.get_vars(sorts);
         for (unsigned i = 0; i < sorts.size(); ++i) {
@@ -142,11 +180,44 @@ namespace datalog {
             }
             v = m.mk_var(i, sorts[i].get());
             m_subst.apply(2, m_deltas, expr_offset(v, is_tgt?0:1), w);
-            result.push_back(w);            
-        }        
+            result.push_back(w);
+        }
         return result;
     }
 
+    void rule_unifier::get_rule_subst_pair(const rule& tgt, const rule& src,
+                                           expr_ref_vector& s1, expr_ref_vector& s2) {
+        SASSERT(m_ready);
+        sort_ref_vector & tgt_sorts = m_tgt_sort_scratch;
+        sort_ref_vector & src_sorts = m_src_sort_scratch;
+        tgt_sorts.reset();
+        src_sorts.reset();
+        tgt.get_vars(tgt_sorts);
+        src.get_vars(src_sorts);
+        unsigned tgt_sz = tgt_sorts.size();
+        unsigned src_sz = src_sorts.size();
+        unsigned n = tgt_sz > src_sz ? tgt_sz : src_sz;
+        expr_ref v(m), w(m);
+        for (unsigned i = 0; i < n; ++i) {
+            if (i < tgt_sz) {
+                if (!tgt_sorts[i].get()) {
+                    tgt_sorts[i] = m.mk_bool_sort();
+                }
+                v = m.mk_var(i, tgt_sorts[i].get());
+                m_subst.apply(2, m_deltas, expr_offset(v, 0), w);
+                s1.push_back(w);
+            }
+            if (i < src_sz) {
+                if (!src_sorts[i].get()) {
+                    src_sorts[i] = m.mk_bool_sort();
+                }
+                v = m.mk_var(i, src_sorts[i].get());
+                m_subst.apply(2, m_deltas, expr_offset(v, 1), w);
+                s2.push_back(w);
+            }
+        }
+    }
+
 
     // -----------------------------------
     //
@@ -162,9 +233,9 @@ namespace datalog {
         SASSERT(tail_index<tgt.get_positive_tail_size());
         SASSERT(!tgt.is_neg_tail(tail_index));
 
-        tgt.norm_vars(m_context.get_rule_manager());
+        ensure_normalized(&tgt);
 
-        if (has_quantifier(src)) {
+        if (meta(&src).m_has_q) {
             return false;
         }
 
@@ -180,8 +251,8 @@ namespace datalog {
                   //m_unifier.display(tout << "subst:\n");
                   );
             if (m_pc) {
-                expr_ref_vector s1 = m_unifier.get_rule_subst(tgt, true);
-                expr_ref_vector s2 = m_unifier.get_rule_subst(src, false);
+                expr_ref_vector s1(m), s2(m);
+                m_unifier.get_rule_subst_pair(tgt, src, s1, s2);
                 datalog::resolve_rule(m_pc, tgt, src, tail_index, s1, s2, *res.get());
             }
             return true;        
@@ -193,35 +264,50 @@ namespace datalog {
         }
     }
 
-    bool mk_rule_inliner::has_quantifier(rule const& r) const {
-        unsigned utsz = r.get_uninterpreted_tail_size();
-        for (unsigned i = utsz; i < r.get_tail_size(); ++i) {
-            if (r.get_tail(i)->has_quantifiers()) return true;
+    void mk_rule_inliner::ensure_normalized(rule * r) {
+        if (m_normalized.contains(r)) {
+            return;
         }
-        return false;
+        r->norm_vars(m_context.get_rule_manager());
+        m_normalized.insert(r);
+        m_norm_pinned.push_back(r);
+    }
+
+    mk_rule_inliner::rule_meta const & mk_rule_inliner::meta(rule * r) {
+        rule_meta_map::entry * e = m_meta.insert_if_not_there2(r, rule_meta());
+        rule_meta & m = e->get_data().m_value;
+        if (!m.m_valid) {
+            m.m_pt_sz = r->get_positive_tail_size();
+            m.m_ut_sz = r->get_uninterpreted_tail_size();
+            m.m_has_q = has_quantifier(*r);
+            m.m_valid = true;
+            m_meta_pinned.push_back(r);
+        }
+        return m;
     }
 
     void mk_rule_inliner::count_pred_occurrences(rule_set const & orig)
     {
         m_context.get_rmanager().collect_non_empty_predicates(m_preds_with_facts);
 
-        rule_set::iterator rend = orig.end();
-        for (rule_set::iterator rit = orig.begin(); rit!=rend; ++rit) {
-            rule * r = *rit;
-            func_decl * head_pred = r->get_decl();
-            m_head_pred_ctr.inc(head_pred);
+        rule * const * rs = orig.begin();
+        unsigned rule_cnt = orig.get_num_rules();
+        for (unsigned ri = 0; ri < rule_cnt; ++ri) {
+            rule * r = rs[ri];
+            unsigned head_id = decl_id(r->get_decl());
+            m_head_pred_cnt[head_id]++;
 
             if (r->get_tail_size()>0) {
-                m_head_pred_non_empty_tails_ctr.inc(head_pred);
+                m_head_pred_non_empty_tail_cnt[head_id]++;
             }
 
             unsigned ut_len = r->get_uninterpreted_tail_size();
             for (unsigned i=0; i<ut_len; i++) {
-                func_decl * pred = r->get_decl(i);
-                m_tail_pred_ctr.inc(pred);
+                unsigned pred_id = decl_id(r->get_decl(i));
+                m_tail_pred_cnt[pred_id]++;
 
                 if (r->is_neg_tail(i)) {
-                    m_preds_with_neg_occurrence.insert(pred);
+                    m_neg_occurrence_bits.set(pred_id);
                 }
             }
         }
@@ -229,22 +315,34 @@ namespace datalog {
 
     bool mk_rule_inliner::inlining_allowed(func_decl * pred)
     {
+        bool allowed;
+        if (m_allowed_cache.find(pred, allowed)) {
+            return allowed;
+        }
+        allowed = compute_inlining_allowed(pred);
+        m_allowed_cache.insert(pred, allowed);
+        return allowed;
+    }
+
+    bool mk_rule_inliner::compute_inlining_allowed(func_decl * pred)
+    {
+        unsigned id = decl_id(pred);
         if (//these three conditions are important for soundness
             m_context.is_output_predicate(pred) ||
             m_preds_with_facts.contains(pred) ||
-            m_preds_with_neg_occurrence.contains(pred) ||
+            m_neg_occurrence_bits.get(id) ||
             //this condition is used for breaking of cycles among inlined rules
-            m_forbidden_preds.contains(pred)) {
+            m_forbidden_bits.get(id)) {
             return false;
         }
 
-        //these conditions are optional, they avoid possible exponential increase 
+        //these conditions are optional, they avoid possible exponential increase
         //in the size of the problem
 
-        return 
-            //m_head_pred_non_empty_tails_ctr.get(pred)<=1
-            m_head_pred_ctr.get(pred) <= 1
-            || (m_tail_pred_ctr.get(pred) <= 1 && m_head_pred_ctr.get(pred) <= 4)
+        return
+            //m_head_pred_non_empty_tail_cnt[id]<=1
+            m_head_pred_cnt[id] <= 1
+            || (m_tail_pred_cnt[id] <= 1 && m_head_pred_cnt[id] <= 4)
             ;
     }
 
@@ -252,9 +350,10 @@ namespace datalog {
     rule_set * mk_rule_inliner::create_allowed_rule_set(rule_set const & orig) 
     {
         rule_set * res = alloc(rule_set, m_context);
+        rule * const * rs = orig.begin();
         unsigned rcnt = orig.get_num_rules();
         for (unsigned i=0; i<rcnt; i++) {
-            rule * r = orig.get_rule(i);
+            rule * r = rs[i];
             if (inlining_allowed(r->get_decl())) {
                 res->add_rule(r);
             }
@@ -277,9 +376,9 @@ namespace datalog {
         
         const rule_stratifier::comp_vector& comps = r.get_stratifier().get_strats();
 
-        rule_stratifier::comp_vector::const_iterator cend = comps.end();
-        for (rule_stratifier::comp_vector::const_iterator it = comps.begin(); it!=cend; ++it) {
-            rule_stratifier::item_set * stratum = *it;
+        unsigned comp_cnt = comps.size();
+        for (unsigned ci = 0; ci < comp_cnt; ++ci) {
+            rule_stratifier::item_set * stratum = comps[ci];
             if (stratum->size()==1) {
                 continue;
             }
@@ -287,7 +386,7 @@ namespace datalog {
             func_decl * first_stratum_pred = *stratum->begin();
 
             //we're trying to break cycles by removing one predicate from each of them
-            m_forbidden_preds.insert(first_stratum_pred);
+            forbid_pred(first_stratum_pred);
             something_forbidden = true;
         }
         return something_forbidden;
@@ -298,23 +397,24 @@ namespace datalog {
 
         bool something_forbidden = false;
 
-        const rule_stratifier::comp_vector& comps = 
+        const rule_stratifier::comp_vector& comps =
             proposed_inlined_rules.get_stratifier().get_strats();
 
-        rule_stratifier::comp_vector::const_iterator cend = comps.end();
-        for (rule_stratifier::comp_vector::const_iterator it = comps.begin(); it!=cend; ++it) {
-            rule_stratifier::item_set * stratum = *it;
+        unsigned comp_cnt = comps.size();
+        for (unsigned ci = 0; ci < comp_cnt; ++ci) {
+            rule_stratifier::item_set * stratum = comps[ci];
 
             SASSERT(stratum->size()==1);
             func_decl * head_pred = *stratum->begin();
+            unsigned head_id = decl_id(head_pred);
 
-            bool is_multi_head_pred = m_head_pred_ctr.get(head_pred)>1;
-            bool is_multi_occurrence_pred = m_tail_pred_ctr.get(head_pred)>1;
+            bool is_multi_head_pred = m_head_pred_cnt[head_id]>1;
+            bool is_multi_occurrence_pred = m_tail_pred_cnt[head_id]>1;
 
             const rule_vector& pred_rules = proposed_inlined_rules.get_predicate_rules(head_pred);
-            rule_vector::const_iterator iend = pred_rules.end();
-            for (rule_vector::const_iterator iit = pred_rules.begin(); iit!=iend; ++iit) {
-                rule * r = *iit;
+            unsigned pred_rule_cnt = pred_rules.size();
+            for (unsigned pri = 0; pri < pred_rule_cnt; ++pri) {
+                rule * r = pred_rules[pri];
 
                 unsigned pt_len = r->get_positive_tail_size();
                 for (unsigned ti = 0; ti<pt_len; ++ti) {
@@ -322,23 +422,26 @@ namespace datalog {
                     if (!inlining_allowed(tail_pred)) {
                         continue;
                     }
-                    unsigned tail_pred_head_cnt = m_head_pred_ctr.get(tail_pred);
+                    int tail_pred_head_cnt = m_head_pred_cnt[decl_id(tail_pred)];
                     if (tail_pred_head_cnt<=1) {
                         continue;
                     }
                     if (is_multi_head_pred) {
-                        m_forbidden_preds.insert(head_pred);
+                        forbid_pred(head_pred);
                         something_forbidden = true;
                         goto process_next_pred;
                     }
                     if (is_multi_occurrence_pred) {
-                        m_forbidden_preds.insert(tail_pred);
+                        forbid_pred(tail_pred);
                         something_forbidden = true;
+                        //tail_pred is forbidden now, so the remaining tails of
+                        //this predicate cannot multiply through it anymore
+                        goto process_next_pred;
                     }
                     else {
                         is_multi_head_pred = true;
-                        m_head_pred_ctr.get(head_pred) = 
-                            m_head_pred_ctr.get(head_pred)*tail_pred_head_cnt;
+                        m_head_pred_cnt[head_id] *= tail_pred_head_cnt;
+                        m_allowed_cache.remove(head_pred);
                     }
                 }
 
@@ -348,9 +451,10 @@ namespace datalog {
         }
 
 
+        rule * const * rs = orig.begin();
         unsigned rule_cnt = orig.get_num_rules();
         for (unsigned ri=0; ri<rule_cnt; ri++) {
-            rule * r = orig.get_rule(ri);
+            rule * r = rs[ri];
 
             func_decl * head_pred = r->get_decl();
 
@@ -366,11 +470,11 @@ namespace datalog {
                 if (!inlining_allowed(pred)) {
                     continue;
                 }
-                if (m_head_pred_ctr.get(pred)<=1) {
+                if (m_head_pred_cnt[decl_id(pred)]<=1) {
                     continue;
                 }
                 if (has_multi_head_pred) {
-                    m_forbidden_preds.insert(pred);
+                    forbid_pred(pred);
                     something_forbidden = true;
                 }
                 else {
@@ -381,17 +485,47 @@ namespace datalog {
         return something_forbidden;
     }
 
+    /**
+       Orders inlined strata cheapest-first: primarily by dependency level (so
+       predicates are still processed only after everything they may inline),
+       secondarily by the number of rules of the predicate, so that small
+       "definitional" predicates are folded in before the expensive ones get to
+       expand the worklist.
+    */
+    struct stratum_cost_lt {
+        obj_map<func_decl, unsigned> & m_level;
+        obj_map<func_decl, unsigned> & m_decl_id;
+        svector<int> const &           m_rule_cnt;
+        stratum_cost_lt(obj_map<func_decl, unsigned> & level,
+                        obj_map<func_decl, unsigned> & decl_id,
+                        svector<int> const & rule_cnt)
+            : m_level(level), m_decl_id(decl_id), m_rule_cnt(rule_cnt) {}
+        bool operator()(rule_stratifier::item_set * s1, rule_stratifier::item_set * s2) const {
+            func_decl * p1 = *s1->begin();
+            func_decl * p2 = *s2->begin();
+            unsigned l1 = m_level.find(p1);
+            unsigned l2 = m_level.find(p2);
+            if (l1 != l2) {
+                return l1 < l2;
+            }
+            return m_rule_cnt[m_decl_id.find(p1)] < m_rule_cnt[m_decl_id.find(p2)];
+        }
+    };
+
     void mk_rule_inliner::plan_inlining(rule_set const & orig)
     {
         count_pred_occurrences(orig);
         
+        //forbidding predicates only ever shrinks the allowed set, so after the
+        //first filtering of orig it suffices to re-filter the previous (smaller)
+        //candidate set instead of walking all original rules again
         scoped_ptr<rule_set> candidate_inlined_set = create_allowed_rule_set(orig);
         while (forbid_preds_from_cycles(*candidate_inlined_set)) {
-            candidate_inlined_set = create_allowed_rule_set(orig);
+            candidate_inlined_set = create_allowed_rule_set(*candidate_inlined_set);
         }
 
         if (forbid_multiple_multipliers(orig, *candidate_inlined_set)) {
-            candidate_inlined_set = create_allowed_rule_set(orig);
+            candidate_inlined_set = create_allowed_rule_set(*candidate_inlined_set);
         }
 
         TRACE("dl", tout<<"rules to be inlined:\n" << (*candidate_inlined_set); );
@@ -403,40 +537,148 @@ namespace datalog {
 
         const rule_stratifier::comp_vector& comps = candidate_inlined_set->get_stratifier().get_strats();
 
-        rule_stratifier::comp_vector::const_iterator cend = comps.end();
-        for (rule_stratifier::comp_vector::const_iterator it = comps.begin(); it!=cend; ++it) {
-            rule_stratifier::item_set * stratum = *it;
+        //assign each stratum its dependency level (comps are already topologically
+        //ordered, so levels of tail predicates are known when we get to a head)
+        obj_map<func_decl, unsigned> pred_level;
+        ptr_vector<rule_stratifier::item_set> ordered_comps;
+        unsigned comp_cnt = comps.size();
+        for (unsigned ci = 0; ci < comp_cnt; ++ci) {
+            rule_stratifier::item_set * stratum = comps[ci];
             SASSERT(stratum->size()==1);
             func_decl * pred = *stratum->begin();
 
+            unsigned level = 0;
             const rule_vector& pred_rules = candidate_inlined_set->get_predicate_rules(pred);
-            rule_vector::const_iterator iend = pred_rules.end();
-            for (rule_vector::const_iterator iit = pred_rules.begin(); iit!=iend; ++iit) {
-                transform_rule(*iit, m_inlined_rules);
+            unsigned pred_rule_cnt = pred_rules.size();
+            for (unsigned pri = 0; pri < pred_rule_cnt; ++pri) {
+                rule * r = pred_rules[pri];
+                unsigned pt_len = r->get_positive_tail_size();
+                for (unsigned ti = 0; ti < pt_len; ++ti) {
+                    unsigned tail_level;
+                    if (pred_level.find(r->get_decl(ti), tail_level) && tail_level+1 > level) {
+                        level = tail_level+1;
+                    }
+                }
+            }
+            pred_level.insert(pred, level);
+            ordered_comps.push_back(stratum);
+        }
+
+        //within a level the predicates are independent, so we are free to process
+        //the cheap ones first and keep the worklist of transform_rule small
+        std::stable_sort(ordered_comps.begin(), ordered_comps.end(),
+                         stratum_cost_lt(pred_level, m_decl_id, m_head_pred_cnt));
+
+        unsigned ordered_cnt = ordered_comps.size();
+        for (unsigned ci = 0; ci < ordered_cnt; ++ci) {
+            func_decl * pred = *ordered_comps[ci]->begin();
+
+            const rule_vector& pred_rules = candidate_inlined_set->get_predicate_rules(pred);
+            unsigned pred_rule_cnt = pred_rules.size();
+            for (unsigned pri = 0; pri < pred_rule_cnt; ++pri) {
+                transform_rule(pred_rules[pri], m_inlined_rules);
             }
         }
 
         TRACE("dl", tout << "inlined rules after mutual inlining:\n" << m_inlined_rules;  );
     }
 
-    bool mk_rule_inliner::transform_rule(rule * r0, rule_set& tgt) {
-        bool modified = false;
-        rule_ref_vector todo(m_rm);
+    /** Structural hash of a rule: head and tail atoms with their polarities */
+    static unsigned rule_struct_hash(rule * r) {
+        unsigned h = r->get_head()->hash();
+        unsigned sz = r->get_tail_size();
+        for (unsigned i = 0; i < sz; ++i) {
+            h = combine_hash(h, r->get_tail(i)->hash());
+            if (r->is_neg_tail(i)) {
+                h = combine_hash(h, 17);
+            }
+        }
+        return h;
+    }
 
-        todo.push_back(r0);
+    /** The atoms are hash-consed, so pointer comparison decides structural equality */
+    static bool rule_struct_eq(rule * r1, rule * r2) {
+        if (r1->get_head() != r2->get_head()) {
+            return false;
+        }
+        unsigned sz = r1->get_tail_size();
+        if (sz != r2->get_tail_size()) {
+            return false;
+        }
+        for (unsigned i = 0; i < sz; ++i) {
+            if (r1->get_tail(i) != r2->get_tail(i) || r1->is_neg_tail(i) != r2->is_neg_tail(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
 
+    /**
+       Push \c r on the worklist unless a structurally identical rule was
+       already pushed during this transform_rule invocation; identical rules
+       have identical expansions, so processing one of them suffices.
+       On a plain hash collision the rule is pushed anyway -- the dedup may
+       then miss later duplicates, but never loses a distinct rule.
+       Returns true if the rule was pushed.
+    */
+    static bool push_if_fresh(rule * r, rule_ref_vector & todo, u_map<rule *> & seen,
+                              rule_ref_vector & pinned) {
+        unsigned h = rule_struct_hash(r);
+        rule * rep;
+        if (seen.find(h, rep)) {
+            if (rule_struct_eq(rep, r)) {
+                return false;
+            }
+        }
+        else {
+            seen.insert(h, r);
+            pinned.push_back(r);
+        }
+        todo.push_back(r);
+        return true;
+    }
 
+    bool mk_rule_inliner::transform_rule(rule * r0, rule_set& tgt) {
+        bool modified = false;
+        rule_ref_vector todo(m_rm);
+        u_map<rule *> seen;
+
+        // The same (tgt, tail_index, src) triple can be attempted several times
+        // while we expand the worklist; memoize the unification+simplification
+        // result so the work is done only once. With a proof converter the
+        // inlining has side effects on the proof, so we bypass the cache then.
+        bool use_cache = m_pc == 0;
+        m_inline_cache.reset();
+        m_cache_pinned.reset();
+
+        //the cap is only enforced while filling m_inlined_rules: a partially
+        //inlined definition left there is still expanded at its use sites, while
+        //in the final rule set a remaining inlinable tail atom would reference an
+        //eliminated predicate
+        bool may_bail = (&tgt == &m_inlined_rules);
+        unsigned max_rules = m_inline_max_rules;
+        unsigned generated = 0;
+
+        push_if_fresh(r0, todo, seen, m_cache_pinned);
 
         while (!todo.empty()) {
             rule_ref r(todo.back(), m_rm);
             todo.pop_back();
-            unsigned pt_len = r->get_positive_tail_size();
+
+            if (may_bail && generated > max_rules) {
+                TRACE("dl", tout << "inlining cap reached, keeping rule as is\n";);
+                tgt.add_rule(r);
+                continue;
+            }
+
+            rule_meta const & rm = meta(r.get());
+            unsigned pt_len = rm.m_pt_sz;
 
             unsigned i = 0;
 
             for  (; i < pt_len && !inlining_allowed(r->get_decl(i)); ++i) {};
 
-            if (has_quantifier(*r.get())) {
+            if (rm.m_has_q) {
                 continue;
             }
 
@@ -449,12 +691,28 @@ namespace datalog {
 
             func_decl * pred = r->get_decl(i);
             const rule_vector& pred_rules = m_inlined_rules.get_predicate_rules(pred);
-            rule_vector::const_iterator iend = pred_rules.end();
-            for (rule_vector::const_iterator iit = pred_rules.begin(); iit!=iend; ++iit) {
-                rule * inl_rule = *iit;
+            unsigned pred_rule_cnt = pred_rules.size();
+            //each definition of pred may contribute one worklist entry
+            todo.reserve_capacity(todo.size() + pred_rule_cnt);
+            for (unsigned pri = 0; pri < pred_rule_cnt; ++pri) {
+                rule * inl_rule = pred_rules[pri];
+                rule * cached;
+                if (use_cache && m_inline_cache.find(inline_step(r.get(), i, inl_rule), cached)) {
+                    if (cached && push_if_fresh(cached, todo, seen, m_cache_pinned)) {
+                        generated++;
+                    }
+                    continue;
+                }
                 rule_ref inl_result(m_rm);
-                if (try_to_inline_rule(*r.get(), *inl_rule, i, inl_result)) {
-                    todo.push_back(inl_result);
+                bool inlined = try_to_inline_rule(*r.get(), *inl_rule, i, inl_result);
+                if (use_cache) {
+                    if (inlined) {
+                        m_cache_pinned.push_back(inl_result);
+                    }
+                    m_inline_cache.insert(inline_step(r.get(), i, inl_rule), inlined ? inl_result.get() : 0);
+                }
+                if (inlined && push_if_fresh(inl_result, todo, seen, m_cache_pinned)) {
+                    generated++;
                 }
             }
         }
@@ -465,18 +723,28 @@ namespace datalog {
 
         bool something_done = false;
 
-        rule_set::iterator rend = orig.end();
-        for (rule_set::iterator rit = orig.begin(); rit!=rend; ++rit) {
-            rule_ref r(*rit, m_rm);
-            func_decl * pred = r->get_decl();
+        //go head predicate by head predicate: the allowed-check is then done once
+        //per predicate, and consecutive transform_rule calls inline from the same
+        //small group of definitions, which keeps the memoization caches warm
+        rule_set::decl2rules::iterator gend = orig.end_grouped_rules();
+        for (rule_set::decl2rules::iterator git = orig.begin_grouped_rules(); git!=gend; ++git) {
+            func_decl * pred = git->m_key;
 
-            // if inlining is allowed, then we are eliminating 
-            // this relation through inlining, 
+            // if inlining is allowed, then we are eliminating
+            // this relation through inlining,
             // so we don't add its rules to the result
 
-            something_done |= !inlining_allowed(pred) && transform_rule(r, tgt);
+            if (inlining_allowed(pred)) {
+                continue;
+            }
+
+            rule_vector const & pred_rules = *git->m_value;
+            rule_vector::const_iterator rend = pred_rules.end();
+            for (rule_vector::const_iterator rit = pred_rules.begin(); rit!=rend; ++rit) {
+                something_done |= transform_rule(*rit, tgt);
+            }
         }
-        
+
         return something_done;
     }
 
@@ -524,7 +792,7 @@ namespace datalog {
 
         func_decl * head_pred = r->get_decl();
 
-        unsigned pt_len = r->get_positive_tail_size();
+        unsigned pt_len = meta(r).m_pt_sz;
         for (unsigned ti = 0; ti < pt_len; ++ti) {
             
             func_decl * pred = r->get_decl(ti);
@@ -566,7 +834,12 @@ namespace datalog {
                 datalog::del_rule(m_mc, *r);
                 return true;
             }
-            if (!is_oriented_rewriter(inlining_candidate, strat)) {
+            bool oriented;
+            if (!m_oriented_cache.find(inlining_candidate, oriented)) {
+                oriented = is_oriented_rewriter(inlining_candidate, strat);
+                m_oriented_cache.insert(inlining_candidate, oriented);
+            }
+            if (!oriented) {
                 // The rule which should be used for inlining isn't oriented
                 // in a simplifying direction. Inlining with such rule might lead to
                 // infinite loops, so we don't do it.
@@ -583,16 +856,20 @@ namespace datalog {
         return false;
     }
 
-    bool mk_rule_inliner::do_eager_inlining(scoped_ptr<rule_set> & rules) {
+    bool mk_rule_inliner::do_eager_inlining(rule_set const & orig, scoped_ptr<rule_set> & rules) {
         scoped_ptr<rule_set> res = alloc(rule_set, m_context);
         bool done_something = false;
 
-        rule_set::iterator rend = rules->end();
-        for (rule_set::iterator rit = rules->begin(); rit!=rend; ++rit) {
+        //orientation depends on the stratification of \c orig, which stays fixed
+        //for the whole pass below
+        m_oriented_cache.reset();
+
+        rule_set::iterator rend = orig.end();
+        for (rule_set::iterator rit = orig.begin(); rit!=rend; ++rit) {
             rule_ref r(*rit, m_rm);
 
             rule_ref replacement(m_rm);
-            while (r && do_eager_inlining(r, *rules, replacement)) {
+            while (r && do_eager_inlining(r, orig, replacement)) {
                 r = replacement;
                 done_something = true;
             }
@@ -624,49 +901,43 @@ namespace datalog {
        other rule (and it does not occur negatively).
      */
     bool mk_rule_inliner::visitor::operator()(expr* e) {
-        m_unifiers.append(m_positions.find(e));
-        TRACE("dl", 
+        uint_set const & pos = m_positions.find(e);
+        uint_set::iterator pit  = pos.begin();
+        uint_set::iterator pend = pos.end();
+        for (; pit != pend; ++pit) {
+            m_unifiers.push_back(*pit);
+        }
+        TRACE("dl",
               tout << "unifier: " << (m_unifiers.empty()?0:m_unifiers.back());
               tout << " num unifiers: " << m_unifiers.size();
-              tout << " num positions: " << m_positions.find(e).size() << "\n";
+              tout << " num positions: " << pos.num_elems() << "\n";
               output_predicate(m_context, to_app(e), tout); tout << "\n";);
         return true;
     }
 
-    void mk_rule_inliner::visitor::reset(unsigned sz) {
-        m_unifiers.reset();
-        m_can_remove.reset();
-        m_can_remove.resize(sz, true);
-        m_can_expand.reset();
-        m_can_expand.resize(sz, true);
-        m_positions.reset();
-    }
-
-    unsigned_vector const& mk_rule_inliner::visitor::add_position(expr* e, unsigned j) {
-        obj_map<expr, unsigned_vector>::obj_map_entry * et = m_positions.insert_if_not_there2(e, unsigned_vector());
-        et->get_data().m_value.push_back(j);
-        return et->get_data().m_value;
+    void mk_rule_inliner::visitor::add_position(expr* e, unsigned j) {
+        obj_map<expr, uint_set>::obj_map_entry * et = m_positions.insert_if_not_there2(e, uint_set());
+        et->get_data().m_value.insert(j);
     }
 
-    unsigned_vector const& mk_rule_inliner::visitor::del_position(expr* e, unsigned j) {
-        obj_map<expr, unsigned_vector>::obj_map_entry * et = m_positions.find_core(e);        
-        SASSERT(et && et->get_data().m_value.contains(j));
-        et->get_data().m_value.erase(j);
-        return et->get_data().m_value;
+    void mk_rule_inliner::visitor::del_position(expr* e, unsigned j) {
+        obj_map<expr, uint_set>::obj_map_entry * et = m_positions.find_core(e);
+        //the same atom can occur twice in a tail, in which case the second removal is a no-op
+        SASSERT(et);
+        et->get_data().m_value.remove(j);
     }
 
     void mk_rule_inliner::add_rule(rule* r, unsigned i) {
-        svector<bool>& can_remove = m_head_visitor.can_remove();
-        svector<bool>& can_expand = m_head_visitor.can_expand();
         app* head = r->get_head();
         func_decl* headd = head->get_decl();
         m_head_visitor.add_position(head, i);
         m_head_index.insert(head);
+        m_head_decl_ctr.inc(headd);
         m_pinned.push_back(r);
             
         if (m_context.is_output_predicate(headd) ||
             m_preds_with_facts.contains(headd)) {
-            can_remove.set(i, false);
+            m_rule_flags[i] &= ~RF_CAN_REMOVE;
             TRACE("dl", output_predicate(m_context, head, tout << "cannot remove: " << i << " "); tout << "\n";);
         }
 
@@ -675,106 +946,131 @@ namespace datalog {
             app* tail = r->get_tail(j);
             m_tail_visitor.add_position(tail, i);
             m_tail_index.insert(tail);
+            m_tail_decl_ctr.inc(tail->get_decl());
         }
         bool can_exp = 
             tl_sz == 1
             && r->get_positive_tail_size() == 1 
             && !m_preds_with_facts.contains(r->get_decl(0)) 
             && !m_context.is_output_predicate(r->get_decl(0));
-        can_expand.set(i, can_exp);
+        if (can_exp) {
+            m_rule_flags[i] |= RF_CAN_EXPAND;
+        }
+        else {
+            m_rule_flags[i] &= ~RF_CAN_EXPAND;
+        }
     }
 
     void mk_rule_inliner::del_rule(rule* r, unsigned i) {
         app* head = r->get_head();
         m_head_visitor.del_position(head, i);
+        m_head_decl_ctr.update(head->get_decl(), -1);
         unsigned tl_sz = r->get_uninterpreted_tail_size();
         for (unsigned j = 0; j < tl_sz; ++j) {
             app* tail = r->get_tail(j);
             m_tail_visitor.del_position(tail, i);
+            m_tail_decl_ctr.update(tail->get_decl(), -1);
         }        
     }
 
 
 #define PRT(_x_) ((_x_)?"T":"F")
 
-    bool mk_rule_inliner::inline_linear(scoped_ptr<rule_set>& rules) {
-        scoped_ptr<rule_set> res = alloc(rule_set, m_context);
-        bool done_something = false;        
-        unsigned sz = rules->get_num_rules();
+    bool mk_rule_inliner::inline_linear(rule_set const & orig, scoped_ptr<rule_set> & rules) {
+        bool done_something = false;
+        unsigned sz = orig.get_num_rules();
 
-        m_head_visitor.reset(sz);
-        m_tail_visitor.reset(sz);
+        m_head_visitor.reset_positions();
+        m_tail_visitor.reset_positions();
+        //all slots start valid and removable; add_rule refines the flags below
+        m_rule_flags.reset();
+        m_rule_flags.resize(sz, RF_VALID | RF_CAN_REMOVE | RF_CAN_EXPAND);
         m_head_index.reset();
         m_tail_index.reset();
+        m_head_decl_ctr.reset();
+        m_tail_decl_ctr.reset();
 
-        TRACE("dl", rules->display(tout););
+        TRACE("dl", orig.display(tout););
 
-        rule_ref_vector acc(m_rm);
+        rule_ref_vector & acc = m_acc;
+        acc.reset();
+        acc.reserve_capacity(sz);
+        m_pinned.reserve_capacity(m_pinned.size() + sz);
+        rule * const * orig_rules = orig.begin();
         for (unsigned i = 0; i < sz; ++i) {
-            acc.push_back(rules->get_rule(i));
+            acc.push_back(orig_rules[i]);
         }
 
-        // set up unification index. 
-        svector<bool>& can_remove = m_head_visitor.can_remove();
-        svector<bool>& can_expand = m_head_visitor.can_expand();
+        //acc and m_rule_flags form a structure-of-arrays view of the worklist:
+        //accp[i] is the current rule of slot i and flagsp[i] its state byte.
+        //(folding the state into pointer tag bits would conflict with the
+        //reference counting that acc performs on the stored rules)
+        //no push_back after this point, so the raw arrays stay valid even though
+        //slots are overwritten as rules get inlined
+        rule * const * accp = acc.c_ptr();
+        unsigned char * flagsp = m_rule_flags.c_ptr();
 
+        // set up unification index.
         for (unsigned i = 0; i < sz; ++i) {
-            add_rule(acc[i].get(), i);
+            add_rule(accp[i], i);
         }
 
         // initialize substitution.
         var_counter& vc = m_rm.get_var_counter();
-        unsigned max_var = 0;
-        for (unsigned i = 0; i < sz; ++i) {
-            rule* r = acc[i].get();
-            max_var = std::max(max_var, vc.get_max_var(r->get_head()));
-            unsigned tl_sz = r->get_uninterpreted_tail_size();
-            for (unsigned j = 0; j < tl_sz; ++j) {
-                max_var = std::max(max_var, vc.get_max_var(r->get_tail(j)));
-            }
-        }
+        //one batched traversal instead of a walk per atom; atoms shared by
+        //several rules are hash-consed and get visited only once
+        unsigned max_var = vc.get_max_var(sz, accp);
         m_subst.reset();
         m_subst.reserve_vars(max_var+1);
         m_subst.reserve_offsets(std::max(m_tail_index.get_approx_num_regs(), m_head_index.get_approx_num_regs()));
 
-        svector<bool> valid;
-        valid.reset();
-        valid.resize(sz, true);        
+        bool allow_branching = m_inline_linear_branch;
 
-        params_ref const& params = m_context.get_params();
-        bool allow_branching = params.get_bool(":inline-linear-branch", false);
+        //rules eliminated during the pass; the model converter is updated for
+        //all of them in one batch below
+        rule_ref_vector eliminated(m_rm);
 
         for (unsigned i = 0; i < sz; ++i) {
 
             while (true) {
 
-                rule_ref r(acc[i].get(), m_rm);
-                
-                TRACE("dl", r->display(m_context, tout << "processing: " << i << "\n"););
+                rule_ref r(accp[i], m_rm);
+                rule * rp = r.get();
+
+                TRACE("dl", rp->display(m_context, tout << "processing: " << i << "\n"););
                 
-                if (!valid.get(i)) {
+                unsigned char fi = flagsp[i];
+                if (!(fi & RF_VALID)) {
                     TRACE("dl", tout << "invalid: " << i << "\n";);
                     break;
                 }
-                if (!can_expand.get(i)) {
+                if (!(fi & RF_CAN_EXPAND)) {
                     TRACE("dl", tout << "cannot expand: " << i << "\n";);
                     break;
                 }
 
+                if (m_head_decl_ctr.get(rp->get_tail(0)->get_decl()) <= 0) {
+                    //no rule head with this predicate is alive, so the
+                    //substitution tree cannot produce a unifier either
+                    TRACE("dl", tout << "no live head for tail predicate\n";);
+                    break;
+                }
+
                 m_head_visitor.reset();
-                m_head_index.unify(r->get_tail(0), m_head_visitor);
+                m_head_index.unify(rp->get_tail(0), m_head_visitor);
                 unsigned num_head_unifiers = m_head_visitor.get_unifiers().size();
                 if (num_head_unifiers != 1) {
                     TRACE("dl", tout << "no unique unifier " << num_head_unifiers << "\n";);
                     break;
                 }
                 unsigned j = m_head_visitor.get_unifiers()[0];
-                if (!can_remove.get(j) || !valid.get(j) || i == j) {
-                    TRACE("dl", tout << PRT(can_remove.get(j)) << " " << PRT(valid.get(j)) << " " << PRT(i != j) << "\n";);
+                unsigned char fj = flagsp[j];
+                if ((fj & (RF_VALID | RF_CAN_REMOVE)) != (RF_VALID | RF_CAN_REMOVE) || i == j) {
+                    TRACE("dl", tout << PRT(fj & RF_CAN_REMOVE) << " " << PRT(fj & RF_VALID) << " " << PRT(i != j) << "\n";);
                     break;
                 }
                 
-                rule* r2 = acc[j].get();
+                rule* r2 = accp[j];
                
                 // check that the head of r2 only unifies with this single body position.
                 TRACE("dl", output_predicate(m_context, r2->get_head(), tout << "unify head: "); tout << "\n";);
@@ -789,42 +1085,109 @@ namespace datalog {
                 }
                 
                 rule_ref rl_res(m_rm);
-                if (!try_to_inline_rule(*r.get(), *r2, 0, rl_res)) {
-                    TRACE("dl", r->display(m_context, tout << "inlining failed\n"); r2->display(m_context, tout);  );
+                if (!try_to_inline_rule(*rp, *r2, 0, rl_res)) {
+                    TRACE("dl", rp->display(m_context, tout << "inlining failed\n"); r2->display(m_context, tout);  );
                     break;
                 }
                 done_something = true;
-                TRACE("dl", r->display(m_context, tout); r2->display(m_context, tout); rl_res->display(m_context, tout); );
+                TRACE("dl", rp->display(m_context, tout); r2->display(m_context, tout); rl_res->display(m_context, tout); );
 
-                del_rule(r, i);
+                del_rule(rp, i);
                 add_rule(rl_res.get(), i);
                 
 
                 r = rl_res;
-                acc[i] = r.get();
-                can_expand.set(i, can_expand.get(j));
-                
+                rp = r.get();
+                acc[i] = rp;
+                flagsp[i] = (flagsp[i] & ~RF_CAN_EXPAND) | (flagsp[j] & RF_CAN_EXPAND);
+
                 if (num_tail_unifiers == 1) {
                     TRACE("dl", tout << "setting invalid: " << j << "\n";);
-                    valid.set(j, false);
-                    datalog::del_rule(m_mc, *r2);
+                    flagsp[j] &= ~RF_VALID;
+                    if (m_mc) {
+                        eliminated.push_back(r2);
+                    }
                     del_rule(r2, j);
                 }
 
-                max_var = std::max(max_var, vc.get_max_var(*r.get()));
-                m_subst.reserve_vars(max_var+1);
+                //the substitution tree resets the substitution on every unify
+                //call, so the only job left here is to grow the reservation
+                //when the freshly built rule introduced a larger variable index
+                unsigned new_max = vc.get_max_var(*rp);
+                if (new_max > max_var) {
+                    max_var = new_max;
+                    m_subst.reserve_vars(max_var+1);
+                }
+
+            }
+        }
 
+        //flush the model converter updates in elimination order, reusing one
+        //body buffer instead of allocating per deleted rule
+        unsigned elim_cnt = eliminated.size();
+        if (elim_cnt > 0) {
+            expr_ref_vector body(m);
+            for (unsigned k = 0; k < elim_cnt; ++k) {
+                rule & er = *eliminated.get(k);
+                body.reset();
+                unsigned tsz = er.get_tail_size();
+                for (unsigned ti = 0; ti < tsz; ++ti) {
+                    if (er.is_neg_tail(ti)) {
+                        body.push_back(m.mk_not(er.get_tail(ti)));
+                    }
+                    else {
+                        body.push_back(er.get_tail(ti));
+                    }
+                }
+                m_mc->insert(er.get_head(), body.size(), body.c_ptr());
             }
         }
+
         if (done_something) {
             rules = alloc(rule_set, m_context);
-            for (unsigned i = 0; i < sz; ++i) {
-                if (valid.get(i)) {
-                    rules->add_rule(acc[i].get());
+            rules->reserve(sz);
+            unsigned char const * flags = m_rule_flags.c_ptr();
+            unsigned i = 0;
+#if defined(__GNUC__) && defined(_AMD64_)
+            //scan the flag bytes a word at a time; RF_VALID is bit 0 of every
+            //byte, so the masked word has one set bit per surviving rule and
+            //counting trailing zeros enumerates them in order (little endian)
+            for (; i + 8 <= sz; i += 8) {
+                uint64 w;
+                memcpy(&w, flags + i, sizeof(w));
+                w &= 0x0101010101010101ull;
+                //touch the survivors of the next word ahead of time; add_rule
+                //bumps the reference counter of each added rule, and that write
+                //would otherwise miss on rules evicted by the vector growth
+                if (i + 16 <= sz) {
+                    uint64 wn;
+                    memcpy(&wn, flags + i + 8, sizeof(wn));
+                    wn &= 0x0101010101010101ull;
+                    while (wn) {
+                        unsigned b = static_cast<unsigned>(__builtin_ctzll(wn)) >> 3;
+                        __builtin_prefetch(accp[i + 8 + b], 1, 1);
+                        wn &= wn - 1;
+                    }
+                }
+                while (w) {
+                    unsigned b = static_cast<unsigned>(__builtin_ctzll(w)) >> 3;
+                    rules->add_rule(accp[i + b]);
+                    w &= w - 1;
+                }
+            }
+#endif
+            for (; i < sz; ++i) {
+                if (flags[i] & RF_VALID) {
+#if defined(__GNUC__)
+                    if (i + 8 < sz && (flags[i + 8] & RF_VALID)) {
+                        __builtin_prefetch(accp[i + 8], 1, 1);
+                    }
+#endif
+                    rules->add_rule(accp[i]);
                 }
             }
             TRACE("dl", rules->display(tout););
-        }        
+        }
         return done_something;
     }
 
@@ -834,7 +1197,8 @@ namespace datalog {
         ref<horn_subsume_model_converter> hsmc;        
         ref<replace_proof_converter> hpc;
 
-        if (source.get_num_rules() == 0) {
+        const unsigned n = source.get_num_rules();
+        if (DL_INLINER_UNLIKELY(n == 0)) {
             return 0;
         }
 
@@ -847,32 +1211,96 @@ namespace datalog {
         m_mc = hsmc.get();
         m_pc = hpc.get();
 
-        plan_inlining(source);
+        //snapshot the parameters queried during this run; the individual
+        //passes then read the members instead of the string-keyed map.
+        //The key symbols are interned once per process: passing the string
+        //literals would re-hash them in the symbol table on every run
+        static const symbol s_inline_linear(":inline-linear");
+        static const symbol s_inline_linear_branch(":inline-linear-branch");
+        static const symbol s_inline_max_rules(":inline-max-rules");
+        params_ref const& params = m_context.get_params();
+        m_inline_linear_enabled = params.get_bool(s_inline_linear, true);
+        m_inline_linear_branch  = params.get_bool(s_inline_linear_branch, false);
+        m_inline_max_rules      = params.get_uint(s_inline_max_rules, 100000);
 
-        scoped_ptr<rule_set> res = alloc(rule_set, m_context);
+        m_normalized.reset();
+        m_norm_pinned.reset();
+        m_meta.reset();
+        m_meta_pinned.reset();
+        m_allowed_cache.reset();
 
-        something_done = transform_rules(source, *res);
+        plan_inlining(source);
 
-        VERIFY(res->close()); //this transformation doesn't break the negation stratification
+        //when no predicate may be inlined, transform_rules degenerates into a
+        //rule-by-rule copy; detect that and keep working on \c source directly
+        //instead of allocating and filling a copy that would be discarded
+        bool have_candidates = false;
+        {
+            rule * const * rs = source.begin();
+            for (unsigned ri = 0; ri < n && !have_candidates; ++ri) {
+                rule * r = rs[ri];
+                if (inlining_allowed(r->get_decl())) {
+                    have_candidates = true;
+                    break;
+                }
+                unsigned pt_len = r->get_positive_tail_size();
+                for (unsigned ti = 0; ti < pt_len; ++ti) {
+                    if (inlining_allowed(r->get_decl(ti))) {
+                        have_candidates = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        //res stays zero as long as no pass has modified anything; the passes
+        //below read from *res when it is set and from \c source otherwise
+        scoped_ptr<rule_set> res;
+        if (have_candidates) {
+            res = alloc(rule_set, m_context);
+            res->reserve(n);
+            something_done = transform_rules(source, *res);
+            if (!something_done && res->get_num_rules() == n && source.is_closed()) {
+                //nothing was inlined and no rule was dropped (transform_rules
+                //omits rules whose head predicate is being inlined away, so
+                //the rule count must be checked too), hence the copy is
+                //rule-for-rule identical to source; closing it would just
+                //recompute the stratification source already has
+                res = 0;
+            }
+            else {
+                VERIFY(res->close()); //this transformation doesn't break the negation stratification
+            }
+        }
+        else if (!source.is_closed()) {
+            //eager inlining needs the stratifier and \c source is const, so an
+            //unclosed source still forces the copy
+            res = alloc(rule_set, m_context);
+            res->add_rules(source);
+            VERIFY(res->close());
+        }
 
         // try eager inlining
-        if (do_eager_inlining(res)) {
+        if (do_eager_inlining(res ? *res : source, res)) {
             something_done = true;
         }
 
-        params_ref const& params = m_context.get_params();
-            if (params.get_bool(":inline-linear", true) && inline_linear(res)) {
+        if (m_inline_linear_enabled && inline_linear(res ? *res : source, res)) {
             something_done = true;
         }
 
-        if (!something_done) {
+        //once a saturation loop reaches its fixpoint, every further invocation
+        //takes the no-change path
+        if (DL_INLINER_LIKELY(!something_done)) {
             res = 0;
         }
         else {
-            if (mc) {
+            //chaining an empty converter would add a useless indirection (and
+            //a pair of refcount updates) to every later conversion
+            if (mc && !hsmc->empty()) {
                 mc = concat(mc.get(), hsmc.get());
             }
-            if (pc) {
+            if (pc && !hpc->empty()) {
                 pc = concat(pc.get(), hpc.get());
             }
         }
@@ -26,6 +26,9 @@ Revision History:
 #include "unifier.h"
 #include "substitution.h"
 #include "substitution_tree.h"
+#include "map.h"
+#include "uint_set.h"
+#include "bit_vector.h"
 
 namespace datalog {
 
@@ -39,9 +42,15 @@ namespace datalog {
         unifier        m_unif;
         bool           m_ready;
         unsigned       m_deltas[2];
+        /** Number of variable slots m_subst was already reserved for */
+        unsigned       m_reserved_var_cnt;
+        /** Scratch space of get_rule_subst/get_rule_subst_pair, reused across calls */
+        sort_ref_vector m_tgt_sort_scratch;
+        sort_ref_vector m_src_sort_scratch;
     public:
         rule_unifier(rule_manager& rm, context& ctx, ast_manager& m)
-            : m(m), m_rm(rm), m_context(ctx), m_interp_simplifier(ctx), m_subst(m), m_unif(m), m_ready(false) {}
+            : m(m), m_rm(rm), m_context(ctx), m_interp_simplifier(ctx), m_subst(m), m_unif(m), m_ready(false),
+              m_reserved_var_cnt(0), m_tgt_sort_scratch(m), m_src_sort_scratch(m) {}
             
         /** Reset subtitution and unify tail tgt_idx of the target rule and the head of the src rule */
         bool unify_rules(const rule& tgt, unsigned tgt_idx, const rule& src);
@@ -59,6 +68,14 @@ namespace datalog {
         */
         expr_ref_vector get_rule_subst(const rule& r, bool is_tgt);
 
+        /**
+           Retrieve the tgt and src substitutions in a single pass.
+           Equivalent to two get_rule_subst calls, but avoids the second
+           traversal of the substitution and the return-value copies.
+        */
+        void get_rule_subst_pair(const rule& tgt, const rule& src,
+                                 expr_ref_vector& s1, expr_ref_vector& s2);
+
     private:
         void apply(app * a, bool is_tgt, app_ref& res);
 
@@ -76,53 +93,161 @@ namespace datalog {
         class visitor : public st_visitor {
             context& m_context;
             unsigned_vector m_unifiers;
-            svector<bool> m_can_remove, m_can_expand;
-            obj_map<expr, unsigned_vector> m_positions;
+            obj_map<expr, uint_set> m_positions;
         public:
             visitor(context& c, substitution & s): st_visitor(s), m_context(c) {}
             virtual bool operator()(expr* e);
             void         reset() { m_unifiers.reset(); }
-            void         reset(unsigned sz);
-            svector<bool>& can_remove() { return m_can_remove; }
-            svector<bool>& can_expand() { return m_can_expand; }
-            unsigned_vector const& add_position(expr* e, unsigned j);
-            unsigned_vector const& del_position(expr* e, unsigned j);
+            void         reset_positions() { m_unifiers.reset(); m_positions.reset(); }
+            void add_position(expr* e, unsigned j);
+            void del_position(expr* e, unsigned j);
             unsigned_vector const& get_unifiers() { return m_unifiers; }
         };
 
+        //per-rule state of inline_linear, packed into one byte per rule so the
+        //hot checks touch a single dense array
+        enum rule_flag {
+            RF_VALID      = 1,
+            RF_CAN_REMOVE = 2,
+            RF_CAN_EXPAND = 4
+        };
+
         typedef obj_map<func_decl, func_decl *> decl_map;
 
+        /** Key identifying one inlining step: src inlined at tail_index of tgt */
+        struct inline_step {
+            rule *   m_tgt;
+            unsigned m_tail_index;
+            rule *   m_src;
+            inline_step():m_tgt(0),m_tail_index(0),m_src(0) {}
+            inline_step(rule * tgt, unsigned tail_index, rule * src):
+                m_tgt(tgt),m_tail_index(tail_index),m_src(src) {}
+            unsigned hash() const {
+                return combine_hash(combine_hash(get_ptr_hash(m_tgt), m_tail_index), get_ptr_hash(m_src));
+            }
+            bool operator==(inline_step const & other) const {
+                return m_tgt==other.m_tgt && m_tail_index==other.m_tail_index && m_src==other.m_src;
+            }
+        };
+        //rule==0 records a failed inlining attempt
+        typedef map<inline_step, rule *, obj_hash<inline_step>, default_eq<inline_step> > inline_cache;
+
+        typedef ptr_hashtable<rule, ptr_hash<rule>, ptr_eq<rule> > rule_mark;
+
+        typedef map<rule *, bool, ptr_hash<rule>, ptr_eq<rule> > rule_bool_map;
+
+        /** Frequently queried per-rule facts, collected once per rule */
+        struct rule_meta {
+            unsigned m_pt_sz;
+            unsigned m_ut_sz;
+            bool     m_has_q;
+            bool     m_valid;
+            rule_meta():m_pt_sz(0),m_ut_sz(0),m_has_q(false),m_valid(false) {}
+        };
+        typedef map<rule *, rule_meta, ptr_hash<rule>, ptr_eq<rule> > rule_meta_map;
+
         ast_manager &   m;
         rule_manager &  m_rm;
         context &       m_context;
         th_rewriter&    m_simp;
-        rule_ref_vector m_pinned;
-        decl_set        m_forbidden_preds;
-        decl_set        m_preds_with_facts;
-        decl_set        m_preds_with_neg_occurrence;
-        ast_counter     m_head_pred_ctr;
-        ast_counter     m_head_pred_non_empty_tails_ctr;
-        ast_counter     m_tail_pred_ctr;
-        rule_set        m_inlined_rules;
-        horn_subsume_model_converter* m_mc;
-        replace_proof_converter* m_pc;
 
+        //---------- hot state: touched by the per-rule inner loops ----------
 
-        //used in try_to_inline_rule and do_eager_inlining
-        rule_unifier    m_unifier;
-
+        horn_subsume_model_converter* m_mc;
+        replace_proof_converter* m_pc;
+        substitution      m_subst;
         substitution_tree m_head_index;  // for straight-line relation inlining.
         substitution_tree m_tail_index;
-        substitution      m_subst;
+        //number of live head/tail atoms per predicate; lets us skip the more
+        //expensive substitution tree unification when no candidate can exist
+        ast_counter       m_head_decl_ctr;
+        ast_counter       m_tail_decl_ctr;
         visitor           m_head_visitor;
         visitor           m_tail_visitor;
+        //one rule_flag byte per rule slot of inline_linear
+        svector<unsigned char> m_rule_flags;
+        //rule slots of inline_linear; member so that repeated invocations in a
+        //fixpoint reuse the grown buffer instead of reallocating it
+        rule_ref_vector   m_acc;
+
+        //used in try_to_inline_rule and do_eager_inlining
+        rule_unifier    m_unifier;
+
+        //---------- caches filled on demand during a run ----------
+
+        //memoizes try_to_inline_rule results during a single transform_rule fixpoint
+        inline_cache    m_inline_cache;
+        rule_ref_vector m_cache_pinned;
+
+        //rules that have already been normalized by norm_vars; the marked rules are
+        //pinned so that a recycled address cannot be mistaken for a normalized rule
+        rule_mark       m_normalized;
+        rule_ref_vector m_norm_pinned;
+
+        //lazily populated per-rule meta data; pinned for the same aliasing reason
+        rule_meta_map   m_meta;
+        rule_ref_vector m_meta_pinned;
+
+        //per-rule is_oriented_rewriter verdicts for one eager inlining pass; the
+        //candidates are owned by the pass' rule set, so no pinning is needed as
+        //long as the cache is cleared whenever that set changes
+        rule_bool_map   m_oriented_cache;
+
+        //memoized inlining_allowed answers; entries of predicates whose
+        //forbidden status or counters change must be evicted
+        obj_map<func_decl, bool> m_allowed_cache;
+
+        //---------- cold planning state: set up once per run ----------
+
+        //parameter values snapshotted at the start of operator(), so the hot
+        //code reads plain members instead of doing string-keyed map lookups
+        bool            m_inline_linear_enabled;
+        bool            m_inline_linear_branch;
+        unsigned        m_inline_max_rules;
+
+        rule_ref_vector m_pinned;
+        decl_set        m_preds_with_facts;
+        //dense ids for the predicates seen by this transformation; the forbidden
+        //and negative-occurrence sets and the occurrence counters are indexed by
+        //these ids, turning the hot membership tests into plain array accesses
+        obj_map<func_decl, unsigned> m_decl_id;
+        bit_vector      m_forbidden_bits;
+        bit_vector      m_neg_occurrence_bits;
+        svector<int>    m_head_pred_cnt;
+        svector<int>    m_head_pred_non_empty_tail_cnt;
+        svector<int>    m_tail_pred_cnt;
+        rule_set        m_inlined_rules;
 
         bool tail_matches_head(app * tail, app* head);
 
         bool try_to_inline_rule(rule& tgt, rule& src, unsigned tail_index, rule_ref& res);
 
+        /** Memoizing wrapper around compute_inlining_allowed */
         bool inlining_allowed(func_decl * pred);
 
+        bool compute_inlining_allowed(func_decl * pred);
+
+        /** Dense id of \c pred, assigned on first use together with zeroed
+            slots in the id-indexed bit vectors and counters */
+        unsigned decl_id(func_decl * pred) {
+            unsigned id;
+            if (!m_decl_id.find(pred, id)) {
+                id = m_decl_id.size();
+                m_decl_id.insert(pred, id);
+                m_forbidden_bits.push_back(false);
+                m_neg_occurrence_bits.push_back(false);
+                m_head_pred_cnt.push_back(0);
+                m_head_pred_non_empty_tail_cnt.push_back(0);
+                m_tail_pred_cnt.push_back(0);
+            }
+            return id;
+        }
+
+        void forbid_pred(func_decl * pred) {
+            m_forbidden_bits.set(decl_id(pred));
+            m_allowed_cache.remove(pred);
+        }
+
         void count_pred_occurrences(rule_set const & orig);
 
         void plan_inlining(rule_set const & orig);
@@ -155,16 +280,33 @@ namespace datalog {
            The inlining is done as long as it doesn't increase the number of rules
            (i.e. when only one rule defining a predicate can replace tail atom).
            
-           The original rule-set must be closed before passing t this function
+           The original rule-set must be closed before passing t this function.
+
+           Reads from \c orig and replaces \c rules with the new set only when
+           something was inlined, so \c rules may come in as zero.
         */
-        bool do_eager_inlining(scoped_ptr<rule_set> & rules);
+        bool do_eager_inlining(rule_set const & orig, scoped_ptr<rule_set> & rules);
 
-        bool has_quantifier(rule const& r) const;
+        bool has_quantifier(rule const& r) const {
+            unsigned tsz  = r.get_tail_size();
+            for (unsigned i = r.get_uninterpreted_tail_size(); i < tsz; ++i) {
+                if (r.get_tail(i)->has_quantifiers()) return true;
+            }
+            return false;
+        }
+
+        /** Run norm_vars on \c r unless it was already normalized during this transformation */
+        void ensure_normalized(rule * r);
+
+        rule_meta const & meta(rule * r);
 
         /**
            Inline predicates that are known to not be join-points.
+
+           Like do_eager_inlining, reads from \c orig and assigns \c rules only
+           on change.
          */
-        bool inline_linear(scoped_ptr<rule_set>& rules);
+        bool inline_linear(rule_set const & orig, scoped_ptr<rule_set> & rules);
 
         void add_rule(rule* r, unsigned i);
         void del_rule(rule* r, unsigned i);
@@ -176,16 +318,23 @@ namespace datalog {
             m_rm(ctx.get_rule_manager()),
             m_context(ctx),
             m_simp(m_context.get_rewriter()),
-            m_pinned(m_rm),
-            m_inlined_rules(m_context),
-            m_unifier(ctx.get_rule_manager(), ctx, m),
             m_mc(0),
             m_pc(0),
+            m_subst(m),
             m_head_index(m),
             m_tail_index(m),
-            m_subst(m),
             m_head_visitor(ctx, m_subst),
-            m_tail_visitor(ctx, m_subst)
+            m_tail_visitor(ctx, m_subst),
+            m_acc(m_rm),
+            m_unifier(ctx.get_rule_manager(), ctx, m),
+            m_cache_pinned(m_rm),
+            m_norm_pinned(m_rm),
+            m_meta_pinned(m_rm),
+            m_inline_linear_enabled(true),
+            m_inline_linear_branch(false),
+            m_inline_max_rules(100000),
+            m_pinned(m_rm),
+            m_inlined_rules(m_context)
         {}
         virtual ~mk_rule_inliner() { }
 
@@ -199,6 +199,11 @@ namespace datalog {
         void add_rules(const rule_set& src);
         void add_rules(unsigned sz, rule * const * rules);
 
+        /**
+           \brief Make room for \c sz rules without changing the content.
+        */
+        void reserve(unsigned sz) { m_rules.reserve_capacity(sz); }
+
         /**
            \brief This method should be invoked after all rules are added to the rule set.
            It will check if the negation is indeed stratified.
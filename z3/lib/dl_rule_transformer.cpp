@@ -108,6 +108,36 @@ namespace datalog {
 
     void rule_transformer::plugin::remove_duplicate_tails(app_ref_vector& tail, svector<bool>& tail_neg)
     {
+        unsigned sz = tail.size();
+        if (sz<=1) {
+            return;
+        }
+        //short tails are the common case; since the atoms are hash-consed, a
+        //pointer scan is cheaper there than setting up two hashtables
+        if (sz<=8) {
+            unsigned i=0;
+            while(i<tail.size()) {
+                bool dup = false;
+                for (unsigned j=0; j<i; j++) {
+                    if (tail[j].get()==tail[i].get() && tail_neg[j]==tail_neg[i]) {
+                        dup = true;
+                        break;
+                    }
+                }
+                if (dup) {
+                    if (i!=tail.size()-1) {
+                        tail[i] = tail.back();
+                        tail_neg[i] = tail_neg.back();
+                    }
+                    tail.pop_back();
+                    tail_neg.pop_back();
+                }
+                else {
+                    i++;
+                }
+            }
+            return;
+        }
         //one set for positive and one for negative
         obj_hashtable<app> tail_apps[2];
         unsigned i=0;
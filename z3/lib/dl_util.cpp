@@ -576,6 +576,21 @@ namespace datalog {
         return get_max_var(has_var);
     }
 
+    unsigned var_counter::get_max_var(unsigned num_rules, rule * const * rules) {
+        bool has_var = false;
+        for (unsigned i = 0; i < num_rules; i++) {
+            rule const& r = *rules[i];
+            m_todo.push_back(r.get_head());
+            m_scopes.push_back(0);
+            unsigned n = r.get_uninterpreted_tail_size();
+            for (unsigned j = 0; j < n; j++) {
+                m_todo.push_back(r.get_tail(j));
+                m_scopes.push_back(0);
+            }
+        }
+        return get_max_var(has_var);
+    }
+
     unsigned var_counter::get_max_var(expr* e) {
         bool has_var = false;
         m_todo.push_back(e);
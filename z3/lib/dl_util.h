@@ -437,6 +437,12 @@ namespace datalog {
         void count_vars(ast_manager & m, const app * t, int coef = 1);
         void count_vars(ast_manager & m, const rule * r, int coef = 1);
         unsigned get_max_var(const rule& r);
+        /**
+           \brief Maximal variable index over the heads and uninterpreted tail
+           atoms of \c rules. One traversal with shared visited marks, so atoms
+           occurring in several rules are walked only once.
+        */
+        unsigned get_max_var(unsigned num_rules, rule * const * rules);
         unsigned get_max_var(expr* e);
         unsigned get_next_var(expr* e);
     };
@@ -463,6 +469,8 @@ namespace datalog {
         
         void inc(ast * el) { update(el, 1); }
         void dec(ast * el) { update(el, -1); }
+
+        void reset() { m_data.reset(); }
     };
 
     void del_rule(horn_subsume_model_converter* mc, rule& r);
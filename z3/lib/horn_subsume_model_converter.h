@@ -55,7 +55,9 @@ public:
     void insert(app* head, unsigned sz, expr* const* body);
 
     void insert(func_decl* p, expr* body) { m_funcs.push_back(p); m_bodies.push_back(body); }
-    
+
+    bool empty() const { return m_funcs.empty(); }
+
     virtual void operator()(model_ref& m);
 
     virtual model_converter * translate(ast_translation & translator);
@@ -115,6 +115,10 @@ public:
     entry * insert_if_not_there2(key const & k, value const & v) {
         return m_table.insert_if_not_there2(key_data(k, v));
     }
+
+    bool insert_if_not_there_core(key const & k, value const & v, entry * & et) {
+        return m_table.insert_if_not_there_core(key_data(k, v), et);
+    }
         
     entry * find_core(key const & k) const {
         return m_table.find_core(key_data(k));
@@ -21,6 +21,11 @@ Notes:
 #include"rational.h"
 #include"symbol.h"
 #include"dictionary.h"
+#include"buffer.h"
+#include"small_object_allocator.h"
+#if defined(__AVX2__) && defined(__GNUC__)
+#include<immintrin.h>
+#endif
 
 struct param_descrs::imp {
     typedef std::pair<param_kind, char const *> info;
@@ -29,23 +34,42 @@ struct param_descrs::imp {
 
     void insert(symbol const & name, param_kind k, char const * descr) {
         SASSERT(!name.is_numerical());
-        info i;
-        if (m_info.find(name, i)) {
-            SASSERT(i.first == k);
+        //one probe: the slot is located once and filled in place when the
+        //name is new, instead of a find followed by a second lookup
+        dictionary<info>::entry * e;
+        if (!m_info.insert_if_not_there_core(name, info(k, descr), e)) {
+            SASSERT(e->get_data().m_value.first == k);
             return;
         }
-        m_info.insert(name, info(k, descr));
         m_names.push_back(name);
     }
 
+    void insert_bulk(unsigned num, param_descrs::descr const * ds) {
+        //names are usually fresh, but combinators merge the descriptors of
+        //several modules into one set, so a name may already be registered;
+        //such hits keep the existing entry, exactly like insert does
+        m_names.reserve_capacity(m_names.size() + num);
+        for (unsigned i = 0; i < num; i++) {
+            symbol name(ds[i].m_name);
+            SASSERT(!name.is_numerical());
+            dictionary<info>::entry * e;
+            if (m_info.insert_if_not_there_core(name, info(ds[i].m_kind, ds[i].m_descr), e))
+                m_names.push_back(name);
+            else {
+                SASSERT(e->get_data().m_value.first == ds[i].m_kind);
+            }
+        }
+    }
+
     void erase(symbol const & name) {
         m_info.erase(name);
     }
                                     
     param_kind get_kind(symbol const & name) const {
-        info i;
-        if (m_info.find(name, i))
-            return i.first;
+        //find_core avoids copying the (kind, description) pair out of the table
+        dictionary<info>::entry * e = m_info.find_core(name);
+        if (e)
+            return e->get_data().m_value.first;
         return CPK_INVALID;
     }
 
@@ -58,25 +82,24 @@ struct param_descrs::imp {
     }
 
     struct lt {
-        bool operator()(symbol const & s1, symbol const & s2) const { return strcmp(s1.bare_str(), s2.bare_str()) < 0; }
+        bool operator()(symbol const & s1, symbol const & s2) const {
+            return strcmp(s1.bare_str(), s2.bare_str()) < 0;
+        }
     };
 
     void display(std::ostream & out, unsigned indent) const {
-        svector<symbol> names;
-        dictionary<info>::iterator it  = m_info.begin();
-        dictionary<info>::iterator end = m_info.end();
-        for (; it != end; ++it) {
-            names.push_back(it->m_key);
-        }
+        //m_names already holds every registered name contiguously, so sort
+        //a copy of it instead of walking the hash buckets of m_info
+        svector<symbol> names(m_names);
         std::sort(names.begin(), names.end(), lt());
-        svector<symbol>::iterator it2  = names.begin();
-        svector<symbol>::iterator end2 = names.end();
-        for (; it2 != end2; ++it2) {
+        svector<symbol>::iterator it  = names.begin();
+        svector<symbol>::iterator end = names.end();
+        for (; it != end; ++it) {
             for (unsigned i = 0; i < indent; i++) out << " ";
-            out << *it2;
-            info d;
-            d.second = 0;
-            m_info.find(*it2, d);
+            out << *it;
+            dictionary<info>::entry * e = m_info.find_core(*it);
+            SASSERT(e);
+            info const & d = e->get_data().m_value;
             SASSERT(d.second);
             out << " (" << d.first << ") " << d.second << "\n";
         }
@@ -99,6 +122,10 @@ void param_descrs::insert(char const * name, param_kind k, char const * descr) {
     insert(symbol(name), k, descr);
 }
 
+void param_descrs::insert_bulk(unsigned num, descr const * ds) {
+    m_imp->insert_bulk(num, ds);
+}
+
 void param_descrs::erase(symbol const & name) {
     m_imp->erase(name);
 }
@@ -127,52 +154,166 @@ void param_descrs::display(std::ostream & out, unsigned indent) const {
     return m_imp->display(out, indent);
 }
 
+// The parameter names below are interned once per process: the function
+// local statics are built on first use, after initialize_symbols(), and
+// later calls skip the hash-and-lookup in the symbol table.
+
 void insert_max_memory(param_descrs & r) {
-    r.insert(":max-memory", CPK_UINT, "(default: infty) maximum amount of memory in megabytes.");
+    static symbol s(":max-memory");
+    r.insert(s, CPK_UINT, "(default: infty) maximum amount of memory in megabytes.");
 }
 
 void insert_max_steps(param_descrs & r) {
-    r.insert(":max-steps", CPK_UINT, "(default: infty) maximum number of steps.");
+    static symbol s(":max-steps");
+    r.insert(s, CPK_UINT, "(default: infty) maximum number of steps.");
 }
 
 void insert_produce_models(param_descrs & r) {
-    r.insert(":produce-models", CPK_BOOL, "(default: false) model generation.");
+    static symbol s(":produce-models");
+    r.insert(s, CPK_BOOL, "(default: false) model generation.");
 }
 
 void insert_produce_proofs(param_descrs & r) {
-    r.insert(":produce-proofs", CPK_BOOL, "(default: false) proof generation.");
+    static symbol s(":produce-proofs");
+    r.insert(s, CPK_BOOL, "(default: false) proof generation.");
 }
 
 void insert_timeout(param_descrs & r) {
-    r.insert(":timeout", CPK_UINT, "(default: infty) timeout in milliseconds.");
+    static symbol s(":timeout");
+    r.insert(s, CPK_UINT, "(default: infty) timeout in milliseconds.");
+}
+
+// Find the position of an interned symbol in a key array. A symbol is a
+// single pointer and equality is pointer identity, so this is a raw pointer
+// scan; with AVX2 four candidates are compared per instruction.
+static int scan_symbol(symbol const * base, unsigned n, symbol const & key) {
+    unsigned i = 0;
+#if defined(__AVX2__) && defined(__GNUC__)
+    //the reinterpretation below is only sound while a symbol is exactly
+    //one 64-bit pointer; fail the build loudly if that ever changes
+    COMPILE_TIME_ASSERT(sizeof(symbol) == sizeof(long long));
+    if (n >= 4) {
+        long long const * p = reinterpret_cast<long long const *>(base);
+        __m256i kv = _mm256_set1_epi64x(*reinterpret_cast<long long const *>(&key));
+        for (; i + 4 <= n; i += 4) {
+            __m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i)), kv);
+            int mask = _mm256_movemask_epi8(eq);
+            if (mask != 0)
+                return static_cast<int>(i + (__builtin_ctz(mask) >> 3));
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (base[i] == key)
+            return static_cast<int>(i);
+    }
+    return -1;
 }
 
+// below this size a lookup scans m_keys directly instead of probing the
+// hash index; the scan touches one cache line of interned pointers
+#define SMALL_PARAMS_THRESHOLD 8
+
 class params {
     friend class params_ref;
-    struct value {
-        param_kind m_kind;
-        union {
-            bool          m_bool_value;
-            unsigned      m_uint_value;
-            double        m_double_value;
-            char const *  m_str_value;
-            char const *  m_sym_value;
-            rational *    m_rat_value;
-            ast *         m_ast_value;
-        };
+    //the union is a bare 8-byte payload: the kind tag lives out-of-line in
+    //m_kinds, so there is nothing left to pack into pointer low bits, and
+    //doing so anyway would cost CPK_DOUBLE its full 64-bit representation
+    union value {
+        bool          m_bool_value;
+        unsigned      m_uint_value;
+        double        m_double_value;
+        char const *  m_str_value;
+        char const *  m_sym_value;
+        rational *    m_rat_value;
+        ast *         m_ast_value;
     };
-    typedef std::pair<symbol, value> entry;
     ast_manager *  m_manager;
-    svector<entry> m_entries;
+    //entries split into parallel arrays: key, kind (one byte) and value of
+    //slot i live at index i of the three buffers; the inline slots avoid a
+    //heap allocation for the typical handful of entries
+    sbuffer<symbol, 4>        m_keys;
+    sbuffer<unsigned char, 4> m_kinds;
+    sbuffer<value, 4>         m_values;
+    // position of each key in the parallel arrays; makes contains/get/set/
+    // reset a hash lookup instead of a linear scan
+    dictionary<unsigned> m_index;
     unsigned       m_ref_count;
-    
-    void del_value(entry & e);
+    //set when a stored value owns a resource (a pooled rational or a
+    //referenced ast); bags of plain bool/uint/double/string values keep it
+    //false and reset() can skip the per-entry destruction loop entirely
+    bool           m_needs_dtor;
+
+    void del_value(unsigned idx);
     void del_values();
+    void clone_from(params const & src);
+
+    // the index is always kept in sync, but small objects are cheaper to
+    // scan than to probe: the keys sit in the inline buffer. Keeping the
+    // keys sorted for binary search was considered instead and rejected:
+    // above the scan threshold the hash probe is already O(1), and a sort
+    // order would have to be restored after every swap-erase in reset()
+    bool find_pos(symbol const & k, unsigned & idx) const {
+        unsigned sz = m_keys.size();
+        if (sz <= SMALL_PARAMS_THRESHOLD) {
+            int i = scan_symbol(m_keys.begin(), sz, k);
+            if (i < 0)
+                return false;
+            idx = static_cast<unsigned>(i);
+            return true;
+        }
+        return m_index.find(k, idx);
+    }
+
+    //pool for the rationals owned by CPK_NUMERAL values; created on first
+    //use so params objects without numerals pay only for the pointer
+    small_object_allocator * m_rat_alloc;
+
+    rational * mk_rat(rational const & v) {
+        if (m_rat_alloc == 0)
+            m_rat_alloc = alloc(small_object_allocator, "params");
+        m_needs_dtor = true;
+        return new (m_rat_alloc->allocate(sizeof(rational))) rational(v);
+    }
+
+    void del_rat(rational * r) {
+        r->~rational();
+        m_rat_alloc->deallocate(sizeof(rational), r);
+    }
+
+    // per-kind handlers; indexing these tables by m_kind replaces the
+    // kind switch in the entry loops of display and copy_core
+    typedef void (*copy_fn)(params & dst, symbol const & k, value const & v);
+    typedef void (*display_fn)(std::ostream & out, value const & v);
+    static copy_fn const    g_copy_fns[CPK_INVALID + 1];
+    static display_fn const g_display_fns[CPK_INVALID + 1];
+
+    static void copy_bool(params & dst, symbol const & k, value const & v) { dst.set_bool(k, v.m_bool_value); }
+    static void copy_uint(params & dst, symbol const & k, value const & v) { dst.set_uint(k, v.m_uint_value); }
+    static void copy_double(params & dst, symbol const & k, value const & v) { dst.set_double(k, v.m_double_value); }
+    static void copy_rat(params & dst, symbol const & k, value const & v) { dst.set_rat(k, *(v.m_rat_value)); }
+    static void copy_sym(params & dst, symbol const & k, value const & v) { dst.set_sym(k, symbol::mk_symbol_from_c_ptr(v.m_sym_value)); }
+    static void copy_str(params & dst, symbol const & k, value const & v) { dst.set_str(k, v.m_str_value); }
+    static void copy_expr(params & dst, symbol const & k, value const & v) { dst.set_expr(k, static_cast<expr*>(v.m_ast_value)); }
+    static void copy_func_decl(params & dst, symbol const & k, value const & v) { dst.set_func_decl(k, static_cast<func_decl*>(v.m_ast_value)); }
+    static void copy_sort(params & dst, symbol const & k, value const & v) { dst.set_sort(k, static_cast<sort*>(v.m_ast_value)); }
+    static void copy_invalid(params &, symbol const &, value const &) { UNREACHABLE(); }
+
+    static void display_bool(std::ostream & out, value const & v) { out << " " << v.m_bool_value; }
+    static void display_uint(std::ostream & out, value const & v) { out << " " << v.m_uint_value; }
+    static void display_double(std::ostream & out, value const & v) { out << " " << v.m_double_value; }
+    static void display_rat(std::ostream & out, value const & v) { out << " " << *(v.m_rat_value); }
+    static void display_sym(std::ostream & out, value const & v) { out << " " << symbol::mk_symbol_from_c_ptr(v.m_sym_value); }
+    static void display_str(std::ostream & out, value const & v) { out << " " << v.m_str_value; }
+    static void display_ast(std::ostream & out, value const & v) { out << " #" << v.m_ast_value->get_id(); }
+    static void display_invalid(std::ostream &, value const &) { UNREACHABLE(); }
 
 public:
-    params():m_manager(0), m_ref_count(0) {}
+    params():m_manager(0), m_ref_count(0), m_needs_dtor(false), m_rat_alloc(0) {}
     ~params() {
         reset();
+        if (m_rat_alloc)
+            dealloc(m_rat_alloc);
     }
 
     void inc_ref() { m_ref_count++; }
@@ -180,7 +321,7 @@ public:
 
     void set_manager(ast_manager & m);
 
-    bool empty() const { return m_entries.empty(); }
+    bool empty() const { return m_keys.empty(); }
     bool contains(symbol const & k) const;
     bool contains(char const * k) const;
 
@@ -188,15 +329,19 @@ public:
     void reset(symbol const & k);
     void reset(char const * k);
 
+    //one get_kind probe per user-supplied entry. Encoding small descriptor
+    //sets as a 64-bit membership bitmap was considered and rejected: the
+    //subset test would still need a probe per entry to map each name to
+    //its bit, which is exactly the work the loop below already does, and
+    //the kind check comes for free with the probe
     void validate(param_descrs const & p) const {
-        svector<params::entry>::const_iterator it  = m_entries.begin();  
-        svector<params::entry>::const_iterator end = m_entries.end();
-        for (; it != end; ++it) {                                
-            param_kind expected = p.get_kind(it->first);
+        unsigned sz = m_keys.size();
+        for (unsigned i = 0; i < sz; i++) {
+            param_kind expected = p.get_kind(m_keys[i]);
             if (expected == CPK_INVALID)
-                throw default_exception("unknown parameter '%s'", it->first.str().c_str());
-            if (it->second.m_kind != expected) 
-                throw default_exception("parameter kind mismatch '%s'", it->first.str().c_str());
+                throw default_exception("unknown parameter '%s'", m_keys[i].str().c_str());
+            if (m_kinds[i] != expected)
+                throw default_exception("parameter kind mismatch '%s'", m_keys[i].str().c_str());
         }
     }
     
@@ -242,43 +387,63 @@ public:
 
     void display(std::ostream & out) const {
         out << "(params";
-        svector<params::entry>::const_iterator it  = m_entries.begin();  
-        svector<params::entry>::const_iterator end = m_entries.end();
-        for (; it != end; ++it) {                                
-            out << " " << it->first;
-            switch (it->second.m_kind) {
-            case CPK_BOOL:
-                out << " " << it->second.m_bool_value;
-                break;
-            case CPK_UINT:
-                out << " " <<it->second.m_uint_value;
-                break;
-            case CPK_DOUBLE:
-                out << " " << it->second.m_double_value;
-                break;
-            case CPK_NUMERAL:
-                out << " " << *(it->second.m_rat_value);
-                break;
-            case CPK_SYMBOL:
-                out << " " << symbol::mk_symbol_from_c_ptr(it->second.m_sym_value);
-                break;
-            case CPK_STRING:
-                out << " " << it->second.m_str_value;
-                break;
-            case CPK_EXPR:
-            case CPK_FUNC_DECL:
-            case CPK_SORT:
-                out << " #" << it->second.m_ast_value->get_id();
-                break;
-            default:
-                UNREACHABLE();
-                break;
-            }
+        unsigned sz = m_keys.size();
+        for (unsigned i = 0; i < sz; i++) {
+            out << " " << m_keys[i];
+            g_display_fns[m_kinds[i]](out, m_values[i]);
         }
         out << ")";
     }
 };
 
+// indexed by param_kind; the kinds params never stores map to the
+// UNREACHABLE handlers
+params::copy_fn const params::g_copy_fns[CPK_INVALID + 1] = {
+    copy_uint,      // CPK_UINT
+    copy_bool,      // CPK_BOOL
+    copy_double,    // CPK_DOUBLE
+    copy_rat,       // CPK_NUMERAL
+    copy_invalid,   // CPK_DECIMAL
+    copy_str,       // CPK_STRING
+    copy_invalid,   // CPK_OPTION_VALUE
+    copy_invalid,   // CPK_KEYWORD
+    copy_sym,       // CPK_SYMBOL
+    copy_invalid,   // CPK_SYMBOL_LIST
+    copy_sort,      // CPK_SORT
+    copy_invalid,   // CPK_SORT_LIST
+    copy_expr,      // CPK_EXPR
+    copy_invalid,   // CPK_EXPR_LIST
+    copy_func_decl, // CPK_FUNC_DECL
+    copy_invalid,   // CPK_FUNC_DECL_LIST
+    copy_invalid,   // CPK_SORTED_VAR
+    copy_invalid,   // CPK_SORTED_VAR_LIST
+    copy_invalid,   // CPK_SEXPR
+    copy_invalid    // CPK_INVALID
+};
+
+params::display_fn const params::g_display_fns[CPK_INVALID + 1] = {
+    display_uint,    // CPK_UINT
+    display_bool,    // CPK_BOOL
+    display_double,  // CPK_DOUBLE
+    display_rat,     // CPK_NUMERAL
+    display_invalid, // CPK_DECIMAL
+    display_str,     // CPK_STRING
+    display_invalid, // CPK_OPTION_VALUE
+    display_invalid, // CPK_KEYWORD
+    display_sym,     // CPK_SYMBOL
+    display_invalid, // CPK_SYMBOL_LIST
+    display_ast,     // CPK_SORT
+    display_invalid, // CPK_SORT_LIST
+    display_ast,     // CPK_EXPR
+    display_invalid, // CPK_EXPR_LIST
+    display_ast,     // CPK_FUNC_DECL
+    display_invalid, // CPK_FUNC_DECL_LIST
+    display_invalid, // CPK_SORTED_VAR
+    display_invalid, // CPK_SORTED_VAR_LIST
+    display_invalid, // CPK_SEXPR
+    display_invalid  // CPK_INVALID
+};
+
 params_ref::~params_ref() {
     if (m_params)
         m_params->dec_ref();
@@ -322,41 +487,9 @@ void params_ref::copy(params_ref const & src) {
 void params_ref::copy_core(params const * src) {
     if (src == 0)
         return;
-    svector<params::entry>::const_iterator it  = src->m_entries.begin();  
-    svector<params::entry>::const_iterator end = src->m_entries.end();    
-    for (; it != end; ++it) {                                
-        switch (it->second.m_kind) {
-        case CPK_BOOL:
-            m_params->set_bool(it->first, it->second.m_bool_value);
-            break;
-        case CPK_UINT:
-            m_params->set_uint(it->first, it->second.m_uint_value);
-            break;
-        case CPK_DOUBLE:
-            m_params->set_double(it->first, it->second.m_double_value);
-            break;
-        case CPK_NUMERAL:
-            m_params->set_rat(it->first, *(it->second.m_rat_value));
-            break;
-        case CPK_SYMBOL:
-            m_params->set_sym(it->first, symbol::mk_symbol_from_c_ptr(it->second.m_sym_value));
-            break;
-        case CPK_STRING:
-            m_params->set_str(it->first, it->second.m_str_value);
-            break;
-        case CPK_EXPR:
-            m_params->set_expr(it->first, static_cast<expr*>(it->second.m_ast_value));
-            break;
-        case CPK_FUNC_DECL:
-            m_params->set_func_decl(it->first, static_cast<func_decl*>(it->second.m_ast_value));
-            break;
-        case CPK_SORT:
-            m_params->set_sort(it->first, static_cast<sort*>(it->second.m_ast_value));
-            break;
-        default:
-            UNREACHABLE();
-            break;
-        }
+    unsigned sz = src->m_keys.size();
+    for (unsigned i = 0; i < sz; i++) {
+        params::g_copy_fns[src->m_kinds[i]](*m_params, src->m_keys[i], src->m_values[i]);
     }
 }
 
@@ -369,28 +502,29 @@ void params_ref::init() {
         params * old = m_params;
         m_params = alloc(params);
         m_params->inc_ref();
-        m_params->m_manager = old->m_manager;
-        copy_core(old);
+        //the fresh object is empty, so a direct clone beats replaying the
+        //setters entry by entry
+        m_params->clone_from(*old);
         old->dec_ref();
     }
     
     SASSERT(m_params->m_ref_count == 1);
 }
 
-bool params_ref::get_bool(symbol const & k, bool _default) const { return m_params ? m_params->get_bool(k, _default) : _default; }
-bool params_ref::get_bool(char const * k, bool _default) const { return m_params ? m_params->get_bool(k, _default) : _default; }
-unsigned params_ref::get_uint(symbol const & k, unsigned _default) const { return m_params ? m_params->get_uint(k, _default) : _default; }
-unsigned params_ref::get_uint(char const * k, unsigned _default) const { return m_params ? m_params->get_uint(k, _default) : _default; }
-double params_ref::get_double(symbol const & k, double _default) const { return m_params ? m_params->get_double(k, _default) : _default; }
-double params_ref::get_double(char const * k, double _default) const { return m_params ? m_params->get_double(k, _default) : _default; }
-char const * params_ref::get_str(symbol const & k, char const * _default) const { return m_params ? m_params->get_str(k, _default) : _default; }
-char const * params_ref::get_str(char const * k, char const * _default) const { return m_params ? m_params->get_str(k, _default) : _default; }
-expr * params_ref::get_expr(symbol const & k, expr * _default) const { return m_params ? m_params->get_expr(k, _default) : _default; }
-expr * params_ref::get_expr(char const * k, expr * _default) const { return m_params ? m_params->get_expr(k, _default) : _default; }
-func_decl * params_ref::get_func_decl(symbol const & k, func_decl * _default) const { return m_params ? m_params->get_func_decl(k, _default) : _default; }
-func_decl * params_ref::get_func_decl(char const * k, func_decl * _default) const { return m_params ? m_params->get_func_decl(k, _default) : _default; }
-sort * params_ref::get_sort(symbol const & k, sort * _default) const { return m_params ? m_params->get_sort(k, _default) : _default; }
-sort * params_ref::get_sort(char const * k, sort * _default) const { return m_params ? m_params->get_sort(k, _default) : _default; }
+bool params_ref::get_bool_core(symbol const & k, bool _default) const { return m_params->get_bool(k, _default); }
+bool params_ref::get_bool_core(char const * k, bool _default) const { return m_params->get_bool(k, _default); }
+unsigned params_ref::get_uint_core(symbol const & k, unsigned _default) const { return m_params->get_uint(k, _default); }
+unsigned params_ref::get_uint_core(char const * k, unsigned _default) const { return m_params->get_uint(k, _default); }
+double params_ref::get_double_core(symbol const & k, double _default) const { return m_params->get_double(k, _default); }
+double params_ref::get_double_core(char const * k, double _default) const { return m_params->get_double(k, _default); }
+char const * params_ref::get_str_core(symbol const & k, char const * _default) const { return m_params->get_str(k, _default); }
+char const * params_ref::get_str_core(char const * k, char const * _default) const { return m_params->get_str(k, _default); }
+expr * params_ref::get_expr_core(symbol const & k, expr * _default) const { return m_params->get_expr(k, _default); }
+expr * params_ref::get_expr_core(char const * k, expr * _default) const { return m_params->get_expr(k, _default); }
+func_decl * params_ref::get_func_decl_core(symbol const & k, func_decl * _default) const { return m_params->get_func_decl(k, _default); }
+func_decl * params_ref::get_func_decl_core(char const * k, func_decl * _default) const { return m_params->get_func_decl(k, _default); }
+sort * params_ref::get_sort_core(symbol const & k, sort * _default) const { return m_params->get_sort(k, _default); }
+sort * params_ref::get_sort_core(char const * k, sort * _default) const { return m_params->get_sort(k, _default); }
 
 rational params_ref::get_rat(symbol const & k, rational const & _default) const { 
     return m_params ? m_params->get_rat(k, _default) : _default; 
@@ -400,12 +534,12 @@ rational params_ref::get_rat(char const * k, rational const & _default) const {
     return m_params ? m_params->get_rat(k, _default) : _default; 
 }
 
-symbol params_ref::get_sym(symbol const & k, symbol const & _default) const { 
-    return m_params ? m_params->get_sym(k, _default) : _default; 
+symbol params_ref::get_sym_core(symbol const & k, symbol const & _default) const { 
+    return m_params->get_sym(k, _default); 
 }
 
-symbol params_ref::get_sym(char const * k, symbol const & _default) const { 
-    return m_params ? m_params->get_sym(k, _default) : _default; 
+symbol params_ref::get_sym_core(char const * k, symbol const & _default) const { 
+    return m_params->get_sym(k, _default); 
 }
 
 void params_ref::set_manager(ast_manager & m) {
@@ -413,21 +547,15 @@ void params_ref::set_manager(ast_manager & m) {
     m_params->set_manager(m);
 }
 
-bool params_ref::empty() const {
-    if (!m_params)
-        return true;
+bool params_ref::empty_core() const {
     return m_params->empty();
 }
 
-bool params_ref::contains(symbol const & k) const {
-    if (!m_params)
-        return false;
+bool params_ref::contains_core(symbol const & k) const {
     return m_params->contains(k);
 }
 
-bool params_ref::contains(char const * k) const {
-    if (!m_params)
-        return false;
+bool params_ref::contains_core(char const * k) const {
     return m_params->contains(k);
 }
 
@@ -446,42 +574,69 @@ void params_ref::reset(char const * k) {
         m_params->reset(k);
 }
 
+// Re-asserting a value the bag already holds is common in tactic setup
+// code and must not trigger the copy-on-write clone in init(). Each fast
+// path below reads the current value with a default that cannot compare
+// equal to v, so a hit means the entry exists with exactly this value.
+
 void params_ref::set_bool(symbol const & k, bool v) {
+    if (m_params && m_params->get_bool(k, !v) == v)
+        return;
     init();
     m_params->set_bool(k, v);
 }
 
 void params_ref::set_bool(char const * k, bool  v) {
+    if (m_params && m_params->get_bool(k, !v) == v)
+        return;
     init();
     m_params->set_bool(k, v);
 }
 
 void params_ref::set_uint(symbol const & k, unsigned v) {
+    if (m_params && m_params->get_uint(k, ~v) == v)
+        return;
     init();
     m_params->set_uint(k, v);
 }
 
 void params_ref::set_uint(char const * k, unsigned v) {
+    if (m_params && m_params->get_uint(k, ~v) == v)
+        return;
     init();
     m_params->set_uint(k, v);
 }
 
 void params_ref::set_double(symbol const & k, double v) {
+    if (m_params && m_params->get_double(k, v == 0.0 ? 1.0 : 0.0) == v)
+        return;
     init();
     m_params->set_double(k, v);
 }
 
 void params_ref::set_double(char const * k, double v) {
+    if (m_params && m_params->get_double(k, v == 0.0 ? 1.0 : 0.0) == v)
+        return;
     init();
     m_params->set_double(k, v);
 }
 
 void params_ref::set_str(symbol const & k, char const * v) {
+    if (m_params && v) {
+        char const * old = m_params->get_str(k, 0);
+        if (old && strcmp(old, v) == 0)
+            return;
+    }
     init();
     m_params->set_str(k, v);
 }
 
 void params_ref::set_str(char const * k, char const * v) {
+    if (m_params && v) {
+        char const * old = m_params->get_str(k, 0);
+        if (old && strcmp(old, v) == 0)
+            return;
+    }
     init();
     m_params->set_str(k, v);
 }
@@ -536,17 +691,16 @@ void params_ref::set_sort(char const * k, sort * v) {
     m_params->set_sort(k, v);
 }
 
-void params::del_value(entry & e) {
-    switch (e.second.m_kind) {
+void params::del_value(unsigned idx) {
+    switch (m_kinds[idx]) {
     case CPK_NUMERAL:
-        if (e.second.m_kind == CPK_NUMERAL)
-            dealloc(e.second.m_rat_value);
+        del_rat(m_values[idx].m_rat_value);
         break;
     case CPK_EXPR:
     case CPK_SORT:
     case CPK_FUNC_DECL:
         SASSERT(m_manager);
-        m_manager->dec_ref(e.second.m_ast_value);
+        m_manager->dec_ref(m_values[idx].m_ast_value);
         return;
     default:
         return;
@@ -557,31 +711,52 @@ void params::set_manager(ast_manager & m) {
     m_manager = &m;
 }
 
-#define TRAVERSE_ENTRIES(CODE) {                        \
-    svector<entry>::iterator it  = m_entries.begin();   \
-    svector<entry>::iterator end = m_entries.end();     \
-    for (; it != end; ++it) {                           \
-        CODE                                            \
-    }                                                   \
-}
+/**
+   \brief Fill an empty params object with copies of the entries of \c src.
 
-#define TRAVERSE_CONST_ENTRIES(CODE) {                          \
-    svector<entry>::const_iterator it  = m_entries.begin();     \
-    svector<entry>::const_iterator end = m_entries.end();       \
-    for (; it != end; ++it) {                                   \
-        CODE                                                    \
-    }                                                           \
+   Unlike replaying the setters, this appends each entry directly: the source
+   has no duplicate keys, so the per-key lookup of the setter path is not
+   needed. Rationals are duplicated and ast values get their own reference.
+*/
+void params::clone_from(params const & src) {
+    SASSERT(empty());
+    m_manager = src.m_manager;
+    unsigned sz = src.m_keys.size();
+    for (unsigned i = 0; i < sz; i++) {
+        value v = src.m_values[i];
+        switch (src.m_kinds[i]) {
+        case CPK_NUMERAL:
+            v.m_rat_value = mk_rat(*src.m_values[i].m_rat_value);
+            break;
+        case CPK_EXPR:
+        case CPK_FUNC_DECL:
+        case CPK_SORT:
+            SASSERT(m_manager);
+            m_manager->inc_ref(v.m_ast_value);
+            m_needs_dtor = true;
+            break;
+        default:
+            break;
+        }
+        m_index.insert(src.m_keys[i], m_keys.size());
+        m_keys.push_back(src.m_keys[i]);
+        m_kinds.push_back(src.m_kinds[i]);
+        m_values.push_back(v);
+    }
 }
 
 void params::del_values() {
-    TRAVERSE_ENTRIES(del_value(*it););
+    unsigned sz = m_keys.size();
+    for (unsigned i = 0; i < sz; i++) {
+        del_value(i);
+    }
 }
 
 #define CONTAINS(k) {                                           \
     if (empty())                                                \
         return false;                                           \
-    TRAVERSE_CONST_ENTRIES(if (it->first == k) return true;);   \
-    return false;                                               \
+    unsigned _idx;                                              \
+    return find_pos(symbol(k), _idx);                           \
 }
 
 bool params::contains(symbol const & k) const {
@@ -593,23 +768,36 @@ bool params::contains(char const * k) const {
 }
 
 void params::reset() {
-    del_values();
-    m_entries.finalize();
+    if (m_needs_dtor) {
+        del_values();
+        m_needs_dtor = false;
+    }
+    m_keys.finalize();
+    m_kinds.finalize();
+    m_values.finalize();
+    m_index.reset();
     SASSERT(empty());
 }
 
-#define RESET(k) {                              \
-    if (empty()) return;                        \
-    TRAVERSE_ENTRIES(if (it->first == k) {      \
-        svector<entry>::iterator it2 = it;      \
-        del_value(*it2);                        \
-        ++it;                                   \
-        for (; it != end; ++it, ++it2) {        \
-            *it2 = *it;                         \
-        }                                       \
-        m_entries.pop_back();                   \
-        return;                                 \
-    });                                         \
+//entry order is not significant for a params object, so the erased slot is
+//filled with the last entry instead of shifting everything after it
+#define RESET(k) {                                      \
+    if (empty()) return;                                \
+    symbol _k(k);                                       \
+    unsigned _idx;                                      \
+    if (!find_pos(_k, _idx)) return;                    \
+    del_value(_idx);                                    \
+    m_index.erase(_k);                                  \
+    unsigned _last = m_keys.size() - 1;                 \
+    if (_idx != _last) {                                \
+        m_keys[_idx]   = m_keys[_last];                 \
+        m_kinds[_idx]  = m_kinds[_last];                \
+        m_values[_idx] = m_values[_last];               \
+        m_index.insert(m_keys[_idx], _idx);             \
+    }                                                   \
+    m_keys.pop_back();                                  \
+    m_kinds.pop_back();                                 \
+    m_values.pop_back();                                \
 }
 
 void params::reset(symbol const & k) {
@@ -621,14 +809,19 @@ void params::reset(char const * k) {
 }
 
 #define GET_VALUE(MATCH_CODE, KIND) {                                           \
-    if (empty()) return _default;                                                \
-    TRAVERSE_CONST_ENTRIES(if (it->first == k && it->second.m_kind == KIND) {   \
-        MATCH_CODE                                                              \
-    });                                                                         \
-    return _default;                                                             \
+    if (!empty()) {                                                             \
+        unsigned _idx;                                                          \
+        if (find_pos(symbol(k), _idx)) {                                        \
+            if (m_kinds[_idx] == KIND) {                                        \
+                value const & _v = m_values[_idx];                              \
+                MATCH_CODE                                                      \
+            }                                                                   \
+        }                                                                       \
+    }                                                                           \
+    return _default;                                                            \
 }
     
-#define GET_SIMPLE_VALUE(FIELD_NAME, KIND) GET_VALUE(return it->second.FIELD_NAME;, KIND)
+#define GET_SIMPLE_VALUE(FIELD_NAME, KIND) GET_VALUE(return _v.FIELD_NAME;, KIND)
 
 bool params::get_bool(symbol const & k, bool _default) const {
     GET_SIMPLE_VALUE(m_bool_value, CPK_BOOL);
@@ -662,83 +855,83 @@ char const * params::get_str(char const * k, char const * _default) const {
     GET_SIMPLE_VALUE(m_str_value, CPK_STRING);
 }
 
+#define GET_RAT_VALUE() {                                               \
+    if (!empty()) {                                                     \
+        unsigned _idx;                                                  \
+        if (find_pos(symbol(k), _idx)) {                                \
+            if (m_kinds[_idx] == CPK_NUMERAL) {                         \
+                return *(m_values[_idx].m_rat_value);                   \
+            }                                                           \
+            if (m_kinds[_idx] == CPK_UINT) {                            \
+                return rational(static_cast<int>(m_values[_idx].m_uint_value)); \
+            }                                                           \
+        }                                                               \
+    }                                                                   \
+    return _default;                                                    \
+}
+
 rational params::get_rat(symbol const & k, rational const & _default) const {
-    if (empty()) return _default;                                               
-    TRAVERSE_CONST_ENTRIES(if (it->first == k) {
-            if (it->second.m_kind == CPK_NUMERAL) {   
-                return *(it->second.m_rat_value);
-            }
-            if (it->second.m_kind == CPK_UINT) {
-                return rational(static_cast<int>(it->second.m_uint_value));
-            }
-        });
-    return _default;                                                            
+    GET_RAT_VALUE();
 }
 
 rational params::get_rat(char const * k, rational const & _default) const {
-    if (empty()) return _default;                                               
-    TRAVERSE_CONST_ENTRIES(if (it->first == k) {
-            if (it->second.m_kind == CPK_NUMERAL) {   
-                return *(it->second.m_rat_value);
-            }
-            if (it->second.m_kind == CPK_UINT) {
-                return rational(static_cast<int>(it->second.m_uint_value));
-            }
-        });
-    return _default;                                                            
+    GET_RAT_VALUE();
 }
 
 symbol params::get_sym(symbol const & k, symbol const & _default) const {
-    GET_VALUE(return symbol::mk_symbol_from_c_ptr(it->second.m_sym_value);, CPK_SYMBOL);
+    GET_VALUE(return symbol::mk_symbol_from_c_ptr(_v.m_sym_value);, CPK_SYMBOL);
 }
 
 symbol params::get_sym(char const * k, symbol const & _default) const {
-    GET_VALUE(return symbol::mk_symbol_from_c_ptr(it->second.m_sym_value);, CPK_SYMBOL);
+    GET_VALUE(return symbol::mk_symbol_from_c_ptr(_v.m_sym_value);, CPK_SYMBOL);
 }
 
 expr * params::get_expr(symbol const & k, expr * _default) const {
-    GET_VALUE(return static_cast<expr*>(it->second.m_ast_value);, CPK_EXPR);
+    GET_VALUE(return static_cast<expr*>(_v.m_ast_value);, CPK_EXPR);
 }
 
 expr * params::get_expr(char const * k, expr * _default) const {
-    GET_VALUE(return static_cast<expr*>(it->second.m_ast_value);, CPK_EXPR);
+    GET_VALUE(return static_cast<expr*>(_v.m_ast_value);, CPK_EXPR);
 }
 
 func_decl * params::get_func_decl(symbol const & k, func_decl * _default) const {
-    GET_VALUE(return static_cast<func_decl*>(it->second.m_ast_value);, CPK_FUNC_DECL);
+    GET_VALUE(return static_cast<func_decl*>(_v.m_ast_value);, CPK_FUNC_DECL);
 }
 
 func_decl * params::get_func_decl(char const * k, func_decl * _default) const {
-    GET_VALUE(return static_cast<func_decl*>(it->second.m_ast_value);, CPK_FUNC_DECL);
+    GET_VALUE(return static_cast<func_decl*>(_v.m_ast_value);, CPK_FUNC_DECL);
 }
 
 sort * params::get_sort(symbol const & k, sort * _default) const {
-    GET_VALUE(return static_cast<sort*>(it->second.m_ast_value);, CPK_SORT);
+    GET_VALUE(return static_cast<sort*>(_v.m_ast_value);, CPK_SORT);
 }
 
 sort * params::get_sort(char const * k, sort * _default) const {
-    GET_VALUE(return static_cast<sort*>(it->second.m_ast_value);, CPK_SORT);
+    GET_VALUE(return static_cast<sort*>(_v.m_ast_value);, CPK_SORT);
 }
 
 #define SET_VALUE(MATCH_CODE, ADD_CODE) {       \
-    TRAVERSE_ENTRIES(if (it->first == k) {      \
+    symbol _k(k);                               \
+    unsigned _idx;                              \
+    if (find_pos(_k, _idx)) {                   \
         MATCH_CODE                              \
         return;                                 \
-    });                                         \
+    }                                           \
     ADD_CODE                                    \
+    m_index.insert(_k, m_keys.size() - 1);      \
 }
 
 #define SET_SIMPLE_VALUE(FIELD_NAME, KIND) SET_VALUE({  \
-    del_value(*it);                                     \
-    it->second.m_kind = KIND;                           \
-    it->second.FIELD_NAME = v;                          \
+    del_value(_idx);                                    \
+    m_kinds[_idx] = static_cast<unsigned char>(KIND);   \
+    m_values[_idx].FIELD_NAME = v;                      \
 },                                                      \
 {                                                       \
-    entry new_entry;                                    \
-    new_entry.first  = symbol(k);                       \
-    new_entry.second.m_kind = KIND;                     \
-    new_entry.second.FIELD_NAME = v;                    \
-    m_entries.push_back(new_entry);                     \
+    value _v;                                           \
+    _v.FIELD_NAME = v;                                  \
+    m_keys.push_back(_k);                               \
+    m_kinds.push_back(static_cast<unsigned char>(KIND)); \
+    m_values.push_back(_v);                             \
 })
 
 // setters
@@ -775,20 +968,21 @@ void params::set_str(char const * k, char const * v) {
 }
 
 #define SET_RAT_VALUE() SET_VALUE({                             \
-    if (it->second.m_kind != CPK_NUMERAL) {                     \
-        del_value(*it);                                         \
-        it->second.m_kind = CPK_NUMERAL;                        \
-        it->second.m_rat_value = alloc(rational);               \
+    if (m_kinds[_idx] != CPK_NUMERAL) {                         \
+        del_value(_idx);                                        \
+        m_kinds[_idx] = static_cast<unsigned char>(CPK_NUMERAL); \
+        m_values[_idx].m_rat_value = mk_rat(v);                 \
+    }                                                           \
+    else {                                                      \
+        *(m_values[_idx].m_rat_value) = v;                      \
     }                                                           \
-    *(it->second.m_rat_value) = v;                              \
 },                                                              \
 {                                                               \
-    entry new_entry;                                            \
-    new_entry.first  = symbol(k);                               \
-    new_entry.second.m_kind = CPK_NUMERAL;                      \
-    new_entry.second.m_rat_value = alloc(rational);             \
-    *(new_entry.second.m_rat_value) = v;                        \
-    m_entries.push_back(new_entry);                             \
+    value _v;                                                   \
+    _v.m_rat_value = mk_rat(v);                                 \
+    m_keys.push_back(_k);                                       \
+    m_kinds.push_back(static_cast<unsigned char>(CPK_NUMERAL)); \
+    m_values.push_back(_v);                                     \
 })
 
 void params::set_rat(symbol const & k, rational const & v) {
@@ -800,16 +994,16 @@ void params::set_rat(char const * k, rational const & v) {
 }
 
 #define SET_SYM_VALUE() SET_VALUE({                     \
-    del_value(*it);                                     \
-    it->second.m_kind = CPK_SYMBOL;                     \
-    it->second.m_sym_value = v.bare_str();              \
+    del_value(_idx);                                    \
+    m_kinds[_idx] = static_cast<unsigned char>(CPK_SYMBOL); \
+    m_values[_idx].m_sym_value = v.bare_str();          \
 },                                                      \
 {                                                       \
-    entry new_entry;                                    \
-    new_entry.first  = symbol(k);                       \
-    new_entry.second.m_kind = CPK_SYMBOL;               \
-    new_entry.second.m_sym_value = v.bare_str();        \
-    m_entries.push_back(new_entry);                     \
+    value _v;                                           \
+    _v.m_sym_value = v.bare_str();                      \
+    m_keys.push_back(_k);                               \
+    m_kinds.push_back(static_cast<unsigned char>(CPK_SYMBOL)); \
+    m_values.push_back(_v);                             \
 })
 
 void params::set_sym(symbol const & k, symbol const & v) {
@@ -823,17 +1017,18 @@ void params::set_sym(char const * k, symbol const & v) {
 #define SET_AST_VALUE(KIND) {                   \
     SASSERT(m_manager);                         \
     m_manager->inc_ref(v);                      \
+    m_needs_dtor = true;                        \
     SET_VALUE({                                 \
-        del_value(*it);                         \
-        it->second.m_kind      = KIND;          \
-        it->second.m_ast_value = v;             \
+        del_value(_idx);                        \
+        m_kinds[_idx] = static_cast<unsigned char>(KIND); \
+        m_values[_idx].m_ast_value = v;         \
     },                                          \
     {                                           \
-        entry new_entry;                        \
-        new_entry.first  = symbol(k);           \
-        new_entry.second.m_kind = KIND;         \
-        new_entry.second.m_ast_value = v;       \
-        m_entries.push_back(new_entry);         \
+        value _v;                               \
+        _v.m_ast_value = v;                     \
+        m_keys.push_back(_k);                   \
+        m_kinds.push_back(static_cast<unsigned char>(KIND)); \
+        m_values.push_back(_v);                 \
     })}
 
 
@@ -29,10 +29,39 @@ typedef cmd_arg_kind param_kind;
 class params;
 class param_descrs;
 
+// a params_ref with no attached params object is by far the most common
+// case: most tactics and engines run without user parameters. The getter
+// forwarders below are inlined so that case costs one predicted branch.
+#ifdef __GNUC__
+#define PARAMS_REF_LIKELY(X) __builtin_expect((X), true)
+#else
+#define PARAMS_REF_LIKELY(X) (X)
+#endif
+
 class params_ref {
     params * m_params;
     void init();
     void copy_core(params const * p);
+    // out-of-line slow paths, only reached when m_params != 0
+    bool get_bool_core(symbol const & k, bool _default) const;
+    bool get_bool_core(char const * k, bool _default) const;
+    unsigned get_uint_core(symbol const & k, unsigned _default) const;
+    unsigned get_uint_core(char const * k, unsigned _default) const;
+    double get_double_core(symbol const & k, double _default) const;
+    double get_double_core(char const * k, double _default) const;
+    char const * get_str_core(symbol const & k, char const * _default) const;
+    char const * get_str_core(char const * k, char const * _default) const;
+    symbol get_sym_core(symbol const & k, symbol const & _default) const;
+    symbol get_sym_core(char const * k, symbol const & _default) const;
+    expr * get_expr_core(symbol const & k, expr * _default) const;
+    expr * get_expr_core(char const * k, expr * _default) const;
+    func_decl * get_func_decl_core(symbol const & k, func_decl * _default) const;
+    func_decl * get_func_decl_core(char const * k, func_decl * _default) const;
+    sort * get_sort_core(symbol const & k, sort * _default) const;
+    sort * get_sort_core(char const * k, sort * _default) const;
+    bool empty_core() const;
+    bool contains_core(symbol const & k) const;
+    bool contains_core(char const * k) const;
 public:
     params_ref():m_params(0) {}
     params_ref(params_ref const & p);
@@ -44,30 +73,31 @@ public:
     void copy(params_ref const & src);
     void append(params_ref const & src) { copy(src); }
      
-    bool get_bool(symbol const & k, bool _default) const;
-    bool get_bool(char const * k, bool _default) const;
-    unsigned get_uint(symbol const & k, unsigned _default) const;
-    unsigned get_uint(char const * k, unsigned _default) const;
-    double get_double(symbol const & k, double _default) const;
-    double get_double(char const * k, double _default) const;
-    char const * get_str(symbol const & k, char const * _default) const;
-    char const * get_str(char const * k, char const * _default) const;
+    bool get_bool(symbol const & k, bool _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_bool_core(k, _default); }
+    bool get_bool(char const * k, bool _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_bool_core(k, _default); }
+    unsigned get_uint(symbol const & k, unsigned _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_uint_core(k, _default); }
+    unsigned get_uint(char const * k, unsigned _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_uint_core(k, _default); }
+    double get_double(symbol const & k, double _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_double_core(k, _default); }
+    double get_double(char const * k, double _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_double_core(k, _default); }
+    char const * get_str(symbol const & k, char const * _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_str_core(k, _default); }
+    char const * get_str(char const * k, char const * _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_str_core(k, _default); }
+    // rational is only forward-declared here, so get_rat stays out-of-line
     rational get_rat(symbol const & k, rational const & _default) const;
     rational get_rat(char const * k, rational const & _default) const;
-    symbol get_sym(symbol const & k, symbol const & _default) const;
-    symbol get_sym(char const * k, symbol const & _default) const;
-    expr * get_expr(symbol const & k, expr * _default) const;
-    expr * get_expr(char const * k, expr * _default) const;
-    func_decl * get_func_decl(symbol const & k, func_decl * _default) const;
-    func_decl * get_func_decl(char const * k, func_decl * _default) const;
-    sort * get_sort(symbol const & k, sort * _default) const;
-    sort * get_sort(char const * k, sort * _default) const;
+    symbol get_sym(symbol const & k, symbol const & _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_sym_core(k, _default); }
+    symbol get_sym(char const * k, symbol const & _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_sym_core(k, _default); }
+    expr * get_expr(symbol const & k, expr * _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_expr_core(k, _default); }
+    expr * get_expr(char const * k, expr * _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_expr_core(k, _default); }
+    func_decl * get_func_decl(symbol const & k, func_decl * _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_func_decl_core(k, _default); }
+    func_decl * get_func_decl(char const * k, func_decl * _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_func_decl_core(k, _default); }
+    sort * get_sort(symbol const & k, sort * _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_sort_core(k, _default); }
+    sort * get_sort(char const * k, sort * _default) const { return PARAMS_REF_LIKELY(m_params == 0) ? _default : get_sort_core(k, _default); }
 
     void set_manager(ast_manager & m);
 
-    bool empty() const;
-    bool contains(symbol const & k) const;
-    bool contains(char const * k) const;
+    bool empty() const { return PARAMS_REF_LIKELY(m_params == 0) || empty_core(); }
+    bool contains(symbol const & k) const { return !PARAMS_REF_LIKELY(m_params == 0) && contains_core(k); }
+    bool contains(char const * k) const { return !PARAMS_REF_LIKELY(m_params == 0) && contains_core(k); }
 
     void reset();
     void reset(symbol const & k);
@@ -106,10 +136,18 @@ class param_descrs {
     struct imp;
     imp *  m_imp;
 public:
+    // plain aggregate so callers can register many parameters from a
+    // static array in one insert_bulk call
+    struct descr {
+        char const * m_name;
+        param_kind   m_kind;
+        char const * m_descr;
+    };
     param_descrs();
     ~param_descrs();
     void insert(char const * name, param_kind k, char const * descr);
     void insert(symbol const & name, param_kind k, char const * descr);
+    void insert_bulk(unsigned num, descr const * ds);
     void erase(char const * name);
     void erase(symbol const & name);
     param_kind get_kind(char const * name) const;
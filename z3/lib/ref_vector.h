@@ -83,6 +83,10 @@ public:
         m_nodes.resize(sz, 0);
     }
 
+    void reserve_capacity(unsigned sz) {
+        m_nodes.reserve_capacity(sz);
+    }
+
     void shrink(unsigned sz) {
         SASSERT(sz <= m_nodes.size());
         dec_range_ref(m_nodes.begin() + sz, m_nodes.end());
@@ -40,6 +40,8 @@ public:
 
     void insert(proof* p) { m_proofs.push_back(p); }
 
+    bool empty() const { return m_proofs.empty(); }
+
     ast_manager& get_manager() { return m; }
 
 };
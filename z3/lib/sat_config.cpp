@@ -104,23 +104,26 @@ namespace sat {
     }
 
     void config::collect_param_descrs(param_descrs & r) {
+        static param_descrs::descr const descrs[] = {
+            { ":phase", CPK_SYMBOL, "(default: caching) phase selection strategy: always-false, always-true, caching, random." },
+            { ":phase-caching-on", CPK_UINT, "(default: 400)" },
+            { ":phase-caching-off", CPK_UINT, "(default: 100)" },
+            { ":restart", CPK_SYMBOL, "(default: luby) restart strategy: luby or geometric." },
+            { ":restart-initial", CPK_UINT, "(default: 100) initial restart (number of conflicts)." },
+            { ":restart-factor", CPK_DOUBLE, "(default: 1.5) restart increment factor for geometric strategy." },
+            { ":random-freq", CPK_DOUBLE, "(default: 0.01) frequency of random case splits." },
+            { ":burst-search", CPK_UINT, "(default: 100) number of conflicts before first global simplification." },
+            { ":max-conflicts", CPK_UINT, "(default: inf) maximum number of conflicts." },
+            { ":gc-strategy", CPK_SYMBOL, "(default: glue-psm) garbage collection strategy: psm, glue, glue-psm, dyn-psm." },
+            { ":gc-initial", CPK_UINT, "(default: 20000) learned clauses garbage collection frequence." },
+            { ":gc-increment", CPK_UINT, "(default: 500) increment to the garbage collection threshold." },
+            { ":gc-small-lbd", CPK_UINT, "(default: 3) learned clauses with small LBD are never deleted (only used in dyn-psm)." },
+            { ":gc-k", CPK_UINT, "(default: 7) learned clauses that are inactive for k gc rounds are permanently deleted (only used in dyn-psm)." },
+            { ":minimize-lemmas", CPK_BOOL, "(default: true) minimize learned clauses." },
+            { ":dyn-sub-res", CPK_BOOL, "(default: true) dynamic subsumption resolution for minimizing learned clauses." }
+        };
         insert_max_memory(r);
-        r.insert(":phase", CPK_SYMBOL, "(default: caching) phase selection strategy: always-false, always-true, caching, random.");
-        r.insert(":phase-caching-on", CPK_UINT, "(default: 400)");
-        r.insert(":phase-caching-off", CPK_UINT, "(default: 100)");
-        r.insert(":restart", CPK_SYMBOL, "(default: luby) restart strategy: luby or geometric.");
-        r.insert(":restart-initial", CPK_UINT, "(default: 100) initial restart (number of conflicts).");  
-        r.insert(":restart-factor", CPK_DOUBLE, "(default: 1.5) restart increment factor for geometric strategy.");
-        r.insert(":random-freq", CPK_DOUBLE, "(default: 0.01) frequency of random case splits.");                                                      
-        r.insert(":burst-search", CPK_UINT, "(default: 100) number of conflicts before first global simplification.");
-        r.insert(":max-conflicts", CPK_UINT, "(default: inf) maximum number of conflicts.");
-        r.insert(":gc-strategy", CPK_SYMBOL, "(default: glue-psm) garbage collection strategy: psm, glue, glue-psm, dyn-psm.");
-        r.insert(":gc-initial", CPK_UINT, "(default: 20000) learned clauses garbage collection frequence.");
-        r.insert(":gc-increment", CPK_UINT, "(default: 500) increment to the garbage collection threshold.");
-        r.insert(":gc-small-lbd", CPK_UINT, "(default: 3) learned clauses with small LBD are never deleted (only used in dyn-psm).");
-        r.insert(":gc-k", CPK_UINT, "(default: 7) learned clauses that are inactive for k gc rounds are permanently deleted (only used in dyn-psm).");
-        r.insert(":minimize-lemmas", CPK_BOOL, "(default: true) minimize learned clauses.");
-        r.insert(":dyn-sub-res", CPK_BOOL, "(default: true) dynamic subsumption resolution for minimizing learned clauses.");
+        r.insert_bulk(sizeof(descrs)/sizeof(descrs[0]), descrs);
     }
 
 };
@@ -419,6 +419,24 @@ public:
         if (s > size())
             resize(s, d);
     }
+
+    // Make sure the vector has capacity for at least s elements without changing its size.
+    // Useful to avoid repeated reallocation when the number of push_back's is known in advance.
+    void reserve_capacity(unsigned s) {
+        if (s <= capacity())
+            return;
+        unsigned sz    = size();
+        unsigned * mem = reinterpret_cast<unsigned*>(memory::allocate(sizeof(T) * s + sizeof(unsigned) * 2));
+        *mem = s;
+        mem++;
+        *mem = sz;
+        mem++;
+        if (m_data) {
+            memcpy(mem, m_data, sz * sizeof(T));
+            free_memory();
+        }
+        m_data = reinterpret_cast<T *>(mem);
+    }
 };
 
 template<typename T>